@@ -0,0 +1,94 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Nicolai Trandafil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class QFile;
+
+namespace everload_tags {
+
+/// Read-only completion vocabulary memory-mapped from a file, the words are not loaded into `QString`s.
+/// Copies share the mapping, so do widgets completing from the same dictionary.
+///
+/// File layout, in native byte order:
+/// - header: magic "EVTAGDIC", version, word count, offsets of the sections;
+/// - `count + 1` 32-bit offsets of the words into the text section;
+/// - text: the UTF-8 words sorted ignoring ASCII case;
+/// - optional prefix index: 65537 32-bit ranks, where the words starting with the (case-folded) byte pair `a b`
+///   begin, at `a * 256 + b`. One byte words go under `b = 0`.
+class CompletionDictionary {
+public:
+    /// Write `words` to `path`, duplicates are dropped
+    /// \return false on a file error or text over 4 GiB
+    static bool write(QString const& path, std::vector<QString> words, bool prefix_index = true);
+
+    /// Map the dictionary at `path`
+    /// \return nullopt when the file can't be mapped or isn't a dictionary
+    static std::optional<CompletionDictionary> open(QString const& path);
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    /// UTF-8 bytes of the word of rank `i`
+    std::string_view bytes(size_t i) const;
+
+    QString word(size_t i) const;
+
+    /// Ranks of the words starting with `prefix`, ignoring ASCII case
+    std::pair<size_t, size_t> matches(QStringView prefix) const;
+
+    /// The first `k` words starting with `prefix`
+    QStringList complete(QStringView prefix, size_t k) const;
+
+    /// The `k` best words matching `pattern` loosely, ranked like `CompletionIndex::completeFuzzy`
+    QStringList completeFuzzy(QStringView pattern, size_t k) const;
+
+private:
+    CompletionDictionary() = default;
+
+    std::shared_ptr<QFile> file;
+    size_t count{0};
+    uchar const* offsets{nullptr};
+    char const* text{nullptr};
+    size_t text_size{0};
+    uchar const* prefix_index{nullptr};
+};
+
+} // namespace everload_tags
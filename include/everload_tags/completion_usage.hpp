@@ -0,0 +1,85 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Nicolai Trandafil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace everload_tags {
+
+/// How often tags were committed, to offer the most used completions first.
+/// Bounded LFU with the Space-Saving policy: once full, a new tag replaces the least used one and inherits its
+/// count, so a count overestimates by at most the evicted count. Not thread-safe, meant for the GUI thread.
+class CompletionUsage {
+public:
+    explicit CompletionUsage(size_t max_size = 1024);
+
+    size_t size() const {
+        return entries.size();
+    }
+
+    size_t maxSize() const {
+        return max_size;
+    }
+
+    /// Count a commit of `text`
+    void record(QString const& text);
+
+    std::uint32_t count(QString const& text) const;
+
+    /// The `k` most used tags starting with `prefix`, ignoring case
+    QStringList top(QStringView prefix, size_t k) const;
+
+    /// Move the most used of `words` first, keeping the order of the equally used
+    void rank(QStringList& words) const;
+
+    /// Serialize to a binary blob
+    QByteArray save() const;
+
+    /// Replace the counts by a blob made by `save`
+    /// \return false when `blob` is malformed, the counts are left untouched then
+    bool restore(QByteArray const& blob);
+
+private:
+    struct Entry {
+        QString text;
+        std::uint32_t count;
+    };
+
+    void insert(QString const& text, std::uint32_t count);
+
+    size_t max_size;
+    std::vector<Entry> entries;
+    std::unordered_map<QString, size_t> positions; ///< text -> index in `entries`
+};
+
+} // namespace everload_tags
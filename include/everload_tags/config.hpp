@@ -30,9 +30,12 @@
 #include <QPoint>
 #include <QRect>
 #include <QSize>
+#include <QStringList>
 
+#include <functional>
 #include <optional>
 #include <sstream>
+#include <stop_token>
 #include <string>
 #include <vector>
 
@@ -116,12 +119,29 @@ struct BehaviorConfig {
     bool restore_cursor_position_on_focus_click = false;
     bool read_only = false;
 
+    /// Complete with the words matching the typed text loosely: anywhere, with gaps or with a typo or two
+    bool fuzzy_completion = false;
+
+    /// Keep the tag texts in a pool shared process-wide, so that the widgets holding the same tags store them once
+    bool intern_tags = false;
+
+    /// `TagsEdit` lays out only the rows around the viewport, estimates the height of the others and lays them out in
+    /// the background, so that very large tag sets open at once
+    bool lazy_layout = false;
+
+    /// Bulk loads of tags measure their texts on several threads
+    bool parallel_measurement = false;
+
     std::string debugString() const {
         std::ostringstream os;
         os << "BehaviorConfig{"
            << "unique: " << unique << "; "
            << "restore_cursor_position_on_focus_click: " << restore_cursor_position_on_focus_click << "; "
-           << "read_only: " << read_only << "}";
+           << "read_only: " << read_only << "; "
+           << "fuzzy_completion: " << fuzzy_completion << "; "
+           << "intern_tags: " << intern_tags << "; "
+           << "lazy_layout: " << lazy_layout << "; "
+           << "parallel_measurement: " << parallel_measurement << "}";
         return os.str();
     }
 };
@@ -131,4 +151,8 @@ struct Config {
     BehaviorConfig behavior{};
 };
 
+/// Answers the completions of `prefix`, called on a worker thread.
+/// Once `stop` is requested the typed text has changed and the answer is discarded, so long lookups should bail out.
+using CompletionProvider = std::function<QStringList(QString const& prefix, std::stop_token stop)>;
+
 } // namespace everload_tags
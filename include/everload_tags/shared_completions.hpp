@@ -0,0 +1,75 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Nicolai Trandafil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "completion_dictionary.hpp"
+
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace everload_tags {
+
+/// Completion vocabulary that many widgets attach to instead of holding a copy each.
+/// The vocabulary is an immutable snapshot; `set` builds a new one and swaps it in, lookups already running finish
+/// on the snapshot they started with. Thread-safe.
+class SharedCompletions {
+public:
+    SharedCompletions();
+    explicit SharedCompletions(std::vector<QString> const& words);
+    explicit SharedCompletions(CompletionDictionary dictionary);
+    ~SharedCompletions();
+
+    SharedCompletions(SharedCompletions const&) = delete;
+    SharedCompletions& operator=(SharedCompletions const&) = delete;
+
+    /// Replace the vocabulary
+    void set(std::vector<QString> const& words);
+    void set(CompletionDictionary dictionary);
+
+    size_t size() const;
+
+    /// The first `k` words starting with `prefix`, ignoring case
+    QStringList complete(QStringView prefix, size_t k) const;
+
+    /// The `k` best words matching `pattern` loosely
+    QStringList completeFuzzy(QStringView pattern, size_t k) const;
+
+private:
+    struct Snapshot;
+
+    std::shared_ptr<Snapshot const> snapshot() const;
+    void swap(std::shared_ptr<Snapshot const> next);
+
+    mutable std::mutex mutex;
+    std::shared_ptr<Snapshot const> current;
+};
+
+} // namespace everload_tags
@@ -24,10 +24,15 @@
 
 #pragma once
 
+#include "completion_usage.hpp"
 #include "config.hpp"
+#include "shared_completions.hpp"
+#include "tags_view.hpp"
 
+#include <QAbstractItemModel>
 #include <QAbstractScrollArea>
 
+#include <chrono>
 #include <memory>
 #include <vector>
 
@@ -51,15 +56,56 @@ public:
     /// Set completions
     void completion(std::vector<QString> const& completions);
     void completion(QStringList const& completions);
+    void completion(CompletionDictionary dictionary);
+
+    /// Attach to a vocabulary shared with other widgets
+    void completion(std::shared_ptr<SharedCompletions const> completions);
+
+    /// Set the usage counts ranking the completions, widgets sharing them learn from each other's commits
+    void completionUsage(std::shared_ptr<CompletionUsage> usage);
+
+    /// Get the usage counts
+    std::shared_ptr<CompletionUsage> completionUsage() const;
+
+    /// Set a completion provider, queried on a worker thread once typing pauses for `delay`.
+    /// Replaces the completions set by `completion`.
+    void completionProvider(CompletionProvider provider,
+                            std::chrono::milliseconds delay = std::chrono::milliseconds(100));
 
     /// Set tags
     void tags(std::vector<QString> const& tags);
     void tags(QStringList const& tags);
 
+    /// Replace `count` tags from `pos` by `tags`, the positions are the ones of `tags()`.
+    /// Like the setter, skips empty and, when unique, present tags. Relayouts and emits `tagsEdited` once.
+    void replaceTags(size_t pos, size_t count, std::vector<QString> const& tags);
+    void replaceTags(size_t pos, size_t count, QStringList const& tags);
+
+    /// Insert `tags` before `pos`, see `replaceTags`
+    void insertTags(size_t pos, std::vector<QString> const& tags);
+    void insertTags(size_t pos, QStringList const& tags);
+
+    /// Append `tags`, see `replaceTags`
+    void appendTags(std::vector<QString> const& tags);
+    void appendTags(QStringList const& tags);
+
+    /// Remove `count` tags from `pos`, see `replaceTags`
+    void removeTags(size_t pos, size_t count);
+
     /// Get tags
     std::vector<QString> tags() const;
     QStringList tags2() const;
 
+    /// View the tags without copying them, invalidated by the next change of the tags
+    TagsView tagsView() const;
+
+    /// Mirror the rows of `column` of a list model: the tags follow its rows and the edits are written back
+    /// through `insertRows`, `removeRows` and `setData`. Nullptr unbinds. The model must outlive the binding.
+    void model(QAbstractItemModel* model, int column = 0);
+
+    /// Get the bound model
+    QAbstractItemModel* model() const;
+
     /// Set config
     void config(Config config);
 
@@ -67,8 +113,21 @@ public:
     Config config() const;
 
 signals:
+    /// Any edit by the user, once per keystroke
     void tagsEdited();
 
+    /// `texts` were inserted at `pos`, positions are the ones of `tags()` as of the change
+    void tagsInserted(int pos, QStringList const& texts);
+
+    /// `texts` were removed from `pos`
+    void tagsRemoved(int pos, QStringList const& texts);
+
+    /// The tag at `pos` is being edited, its text is now `text`
+    void tagModified(int pos, QString const& text);
+
+    /// Editing of the tag at `pos` is over, e.g. by `Space` or by moving to another tag
+    void tagCommitted(int pos, QString const& text);
+
 protected:
     // QWidget
     void paintEvent(QPaintEvent* event) override;
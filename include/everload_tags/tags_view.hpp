@@ -0,0 +1,169 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Nicolai Trandafil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <QObject>
+#include <QPointer>
+#include <QString>
+
+#include <compare>
+#include <cstddef>
+#include <iterator>
+
+namespace everload_tags {
+
+struct Common;
+
+/// Read-only view of the tags, the ones `tags()` would return, without copying them.
+/// Like a container iterator it is invalidated by any change of the tags, see `valid`. Its iterators outlive it.
+class TagsView {
+public:
+    class iterator {
+    public:
+        using iterator_concept = std::random_access_iterator_tag;
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = QString;
+        using difference_type = std::ptrdiff_t;
+        using reference = QString const&;
+
+        iterator() = default;
+
+        reference operator*() const {
+            return at(common, skip, i);
+        }
+
+        reference operator[](difference_type n) const {
+            return at(common, skip, static_cast<size_t>(static_cast<difference_type>(i) + n));
+        }
+
+        iterator& operator++() {
+            ++i;
+            return *this;
+        }
+
+        iterator operator++(int) {
+            auto ret = *this;
+            ++i;
+            return ret;
+        }
+
+        iterator& operator--() {
+            --i;
+            return *this;
+        }
+
+        iterator operator--(int) {
+            auto ret = *this;
+            --i;
+            return ret;
+        }
+
+        iterator& operator+=(difference_type n) {
+            i = static_cast<size_t>(static_cast<difference_type>(i) + n);
+            return *this;
+        }
+
+        iterator& operator-=(difference_type n) {
+            return *this += -n;
+        }
+
+        friend iterator operator+(iterator x, difference_type n) {
+            return x += n;
+        }
+
+        friend iterator operator+(difference_type n, iterator x) {
+            return x += n;
+        }
+
+        friend iterator operator-(iterator x, difference_type n) {
+            return x -= n;
+        }
+
+        friend difference_type operator-(iterator const& a, iterator const& b) {
+            return static_cast<difference_type>(a.i) - static_cast<difference_type>(b.i);
+        }
+
+        friend bool operator==(iterator const& a, iterator const& b) {
+            return a.i == b.i;
+        }
+
+        friend auto operator<=>(iterator const& a, iterator const& b) {
+            return a.i <=> b.i;
+        }
+
+    private:
+        friend class TagsView;
+
+        iterator(Common const* common, size_t skip, size_t i) : common{common}, skip{skip}, i{i} {}
+
+        Common const* common{};
+        size_t skip{};
+        size_t i{};
+    };
+
+    /// Empty view
+    TagsView() = default;
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    QString const& operator[](size_t i) const {
+        return at(common, skip, i);
+    }
+
+    iterator begin() const {
+        return {common, skip, 0};
+    }
+
+    iterator end() const {
+        return {common, skip, count};
+    }
+
+    /// Whether the widget is alive and its tags unchanged since the view was taken, the bindings check it instead of
+    /// crashing
+    bool valid() const;
+
+private:
+    friend class TagsEdit;
+    friend class TagsLineEdit;
+
+    TagsView(Common const& common, QObject const* owner);
+
+    static QString const& at(Common const* common, size_t skip, size_t i);
+
+    Common const* common{};
+    QPointer<QObject const> owner;
+    size_t generation{};
+    size_t skip{};  ///< Index of the editor when it isn't listed, `size()` otherwise
+    size_t count{};
+};
+
+} // namespace everload_tags
@@ -19,3 +19,4 @@ BehaviorConfig = everload_tags.BehaviorConfig
 Config = everload_tags.Config
 TagsLineEdit = everload_tags.TagsLineEdit
 TagsEdit = everload_tags.TagsEdit
+TagsView = everload_tags.TagsView
@@ -1,4 +1,4 @@
-from PySide6.QtCore import QMargins, Signal
+from PySide6.QtCore import QAbstractItemModel, QMargins, Signal
 from PySide6.QtGui import QColor
 from PySide6.QtWidgets import QWidget, QAbstractScrollArea
 import typing
@@ -7,6 +7,19 @@ class BehaviorConfig:
     unique: bool
     restore_cursor_position_on_focus_click: bool
 
+    # Complete with the words matching the typed text loosely: anywhere, with gaps or with a typo or two
+    fuzzy_completion: bool
+
+    # Keep the tag texts in a pool shared process-wide, so that the widgets holding the same tags store them once
+    intern_tags: bool
+
+    # TagsEdit lays out only the rows around the viewport, estimates the height of the others and lays them out in
+    # the background, so that very large tag sets open at once
+    lazy_layout: bool
+
+    # Bulk loads of tags measure their texts on several threads
+    parallel_measurement: bool
+
 class StyleConfig:
     # Padding from the text to the the pill border
     pill_thickness: QMargins = QMargins(7, 7, 8, 7)
@@ -32,8 +45,17 @@ class Config:
     style: StyleConfig
     behavior: BehaviorConfig
 
+class TagsView:  # Raises RuntimeError once the tags change or the widget is gone
+    def __len__(self) -> int: ...
+    def __getitem__(self, i: int) -> str: ...
+    def __iter__(self) -> typing.Iterator[str]: ...
+
 class TagsLineEdit(QWidget):
     tagsEdited: typing.ClassVar[Signal] = ...
+    tagsInserted: typing.ClassVar[Signal] = ...  # (pos, texts)
+    tagsRemoved: typing.ClassVar[Signal] = ...  # (pos, texts)
+    tagModified: typing.ClassVar[Signal] = ...  # (pos, text)
+    tagCommitted: typing.ClassVar[Signal] = ...  # (pos, text)
     def __init__(
         self, parent: QWidget | None = ..., config: Config | None = ...
     ) -> None: ...
@@ -42,6 +64,15 @@ class TagsLineEdit(QWidget):
     def tags(self, tags: list[str]) -> None: ...  # Set tags
     @typing.overload
     def tags(self) -> list[str]: ...  # Get tags
+    def tagsView(self) -> TagsView: ...  # View the tags without copying them
+    def replaceTags(self, pos: int, count: int, tags: list[str]) -> None: ...  # Replace a range of tags
+    def insertTags(self, pos: int, tags: list[str]) -> None: ...  # Insert tags
+    def appendTags(self, tags: list[str]) -> None: ...  # Append tags
+    def removeTags(self, pos: int, count: int) -> None: ...  # Remove a range of tags
+    @typing.overload
+    def model(self, model: QAbstractItemModel | None, column: int = ...) -> None: ...  # Bind to a model column
+    @typing.overload
+    def model(self) -> QAbstractItemModel | None: ...  # Get the bound model
     @typing.overload
     def config(self, config: Config) -> None: ...  # Set config
     @typing.overload
@@ -49,6 +80,10 @@ class TagsLineEdit(QWidget):
 
 class TagsEdit(QAbstractScrollArea):
     tagsEdited: typing.ClassVar[Signal] = ...
+    tagsInserted: typing.ClassVar[Signal] = ...  # (pos, texts)
+    tagsRemoved: typing.ClassVar[Signal] = ...  # (pos, texts)
+    tagModified: typing.ClassVar[Signal] = ...  # (pos, text)
+    tagCommitted: typing.ClassVar[Signal] = ...  # (pos, text)
     def __init__(
         self, parent: QWidget | None = ..., config: Config | None = ...
     ) -> None: ...
@@ -57,6 +92,15 @@ class TagsEdit(QAbstractScrollArea):
     def tags(self, tags: list[str]) -> None: ...  # Set tags
     @typing.overload
     def tags(self) -> list[str]: ...  # Get tags
+    def tagsView(self) -> TagsView: ...  # View the tags without copying them
+    def replaceTags(self, pos: int, count: int, tags: list[str]) -> None: ...  # Replace a range of tags
+    def insertTags(self, pos: int, tags: list[str]) -> None: ...  # Insert tags
+    def appendTags(self, tags: list[str]) -> None: ...  # Append tags
+    def removeTags(self, pos: int, count: int) -> None: ...  # Remove a range of tags
+    @typing.overload
+    def model(self, model: QAbstractItemModel | None, column: int = ...) -> None: ...  # Bind to a model column
+    @typing.overload
+    def model(self) -> QAbstractItemModel | None: ...  # Get the bound model
     @typing.overload
     def config(self, config: Config) -> None: ...  # Set config
     @typing.overload
@@ -22,6 +22,7 @@ set(generated_sources
     ${generated_path}/everload_tags_styleconfig_wrapper.cpp
     ${generated_path}/everload_tags_tagsedit_wrapper.cpp
     ${generated_path}/everload_tags_tagslineedit_wrapper.cpp
+    ${generated_path}/everload_tags_tagsview_wrapper.cpp
     ${generated_path}/everload_tags_wrapper.cpp)
 # =================== Shiboken detection ======================
 # Use provided python interpreter if given.
@@ -3,4 +3,5 @@
 #include "config.hpp"
 #include "tags_edit.hpp"
 #include "tags_line_edit.hpp"
+#include "tags_view.hpp"
 #endif
@@ -24,26 +24,46 @@
 
 #pragma once
 
+#include "completion.hpp"
+#include "string_pool.hpp"
 #include "util.hpp"
 
+#include <QAbstractItemModel>
 #include <QCompleter>
 #include <QFontMetrics>
 #include <QGuiApplication>
 #include <QKeyEvent>
 #include <QPainter>
 #include <QPainterPath>
+#include <QPixmap>
+#include <QPixmapCache>
 #include <QPoint>
+#include <QPointer>
 #include <QRect>
+#include <QStaticText>
 #include <QString>
+#include <QStringListModel>
 #include <QStyleHints>
 #include <QStyleOptionFrame>
 #include <QTextLayout>
+#include <QThread>
+#include <QTransform>
 
+#include <algorithm>
 #include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <functional>
+#include <everload_tags/completion_usage.hpp>
 #include <everload_tags/config.hpp>
+#include <everload_tags/shared_completions.hpp>
+#include <limits>
 #include <ranges>
+#include <span>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 
 #if QT_VERSION < QT_VERSION_CHECK(5, 11, 0)
 #define FONT_METRICS_WIDTH(fmt, ...) fmt.width(__VA_ARGS__)
@@ -64,24 +84,30 @@ struct Style : StyleConfig {
         return crossRect(r, tag_cross_size);
     }
 
+    /// Places a pill of `size` at `lt`, wraps it to the next row if it doesn't `fit`, and advances `lt`
+    static QRect placeRect(QPoint& lt, QSize const& size, StyleConfig const& style, std::optional<QRect> const& fit) {
+        QRect rect(lt, size);
+
+        if (fit) {
+            if (fit->right() < rect.right() && // doesn't fit in current line
+                rect.left() != fit->left()     // doesn't occupy entire line already
+            ) {
+                rect.moveTo(fit->left(), rect.bottom() + style.tag_v_spacing);
+                lt = rect.topLeft();
+            }
+        }
+
+        lt.setX(rect.right() + style.pills_h_spacing);
+        return rect;
+    }
+
     template <std::ranges::output_range<Tag> Range>
     static void calcRects(QPoint& lt, Range&& tags, StyleConfig const& style, QFontMetrics const& fm,
                           std::optional<QRect> const& fit, bool has_cross) {
         for (auto& tag : tags) {
             auto const text_width = FONT_METRICS_WIDTH(fm, tag.text);
-            QRect rect(lt, QSize(style.pillWidth(text_width, has_cross), style.pillHeight(fm.height())));
-
-            if (fit) {
-                if (fit->right() < rect.right() && // doesn't fit in current line
-                    rect.left() != fit->left()     // doesn't occupy entire line already
-                ) {
-                    rect.moveTo(fit->left(), rect.bottom() + style.tag_v_spacing);
-                    lt = rect.topLeft();
-                }
-            }
-
-            tag.rect = rect;
-            lt.setX(rect.right() + style.pills_h_spacing);
+            tag.rect = placeRect(lt, QSize(style.pillWidth(text_width, has_cross), style.pillHeight(fm.height())),
+                                 style, fit);
         }
     }
 
@@ -91,38 +117,81 @@ struct Style : StyleConfig {
         calcRects(lt, tags, *this, fm, fit, has_cross);
     }
 
-    template <std::ranges::input_range Range>
+    /// Pill background along with the cross, cached in `QPixmapCache`. The key covers every style property the sprite
+    /// depends on, so a style change just results in new sprites.
+    static QPixmap pillPixmap(QSize const& size, StyleConfig const& style, QPen pen, bool has_cross, qreal dpr) {
+        if (size.isEmpty()) {
+            return {};
+        }
+
+        auto const key = QStringLiteral("everload_tags_pill_%1x%2_%3_%4_%5_%6_%7_%8")
+                             .arg(size.width())
+                             .arg(size.height())
+                             .arg(style.color.rgba())
+                             .arg(style.rounding_x_radius)
+                             .arg(style.rounding_y_radius)
+                             .arg(has_cross ? style.tag_cross_size : 0)
+                             .arg(pen.color().rgba())
+                             .arg(dpr);
+
+        QPixmap pixmap;
+        if (QPixmapCache::find(key, &pixmap)) {
+            return pixmap;
+        }
+
+        pixmap = QPixmap(size * dpr);
+        pixmap.setDevicePixelRatio(dpr);
+        pixmap.fill(Qt::transparent);
+
+        QPainter p(&pixmap);
+        QRect const r(QPoint{0, 0}, size);
+
+        // draw tag rect
+        QPainterPath path;
+        path.addRoundedRect(r, style.rounding_x_radius, style.rounding_y_radius);
+        p.fillPath(path, style.color);
+
+        if (has_cross) {
+            auto const cross_r = crossRect(r, style.tag_cross_size);
+            pen.setWidth(2);
+            p.setPen(pen);
+            p.setRenderHint(QPainter::Antialiasing);
+            p.drawLine(QLineF(cross_r.topLeft(), cross_r.bottomRight()));
+            p.drawLine(QLineF(cross_r.bottomLeft(), cross_r.topRight()));
+        }
+
+        p.end();
+        QPixmapCache::insert(key, pixmap);
+        return pixmap;
+    }
+
+    /// \param draw_text Draws the text of a tag at the given baseline position
+    template <std::ranges::input_range Range, std::invocable<QPointF const&, Tag const&> DrawText>
     static void drawTags(QPainter& p, Range&& tags, StyleConfig const& style, QFontMetrics const& fm,
-                         QPoint const& offset, bool has_cross) {
+                         QPoint const& offset, bool has_cross, DrawText&& draw_text) {
+        auto const pen = p.pen();
+        auto const dpr = p.device() ? p.device()->devicePixelRatioF() : qreal{1};
+
         for (auto const& tag : tags) {
             QRect const& i_r = tag.rect.translated(offset);
             auto const text_pos =
                 i_r.topLeft() + QPointF(style.pill_thickness.left(), fm.ascent() + ((i_r.height() - fm.height()) / 2));
 
-            // draw tag rect
-            QPainterPath path;
-            path.addRoundedRect(i_r, style.rounding_x_radius, style.rounding_y_radius);
-            p.fillPath(path, style.color);
+            // draw tag rect and cross
+            p.drawPixmap(i_r.topLeft(), pillPixmap(i_r.size(), style, pen, has_cross, dpr));
 
             // draw text
-            p.drawText(text_pos, tag.text);
-
-            if (has_cross) {
-                auto const i_cross_r = crossRect(i_r, style.tag_cross_size);
-
-                QPen pen = p.pen();
-                pen.setWidth(2);
-
-                p.save();
-                p.setPen(pen);
-                p.setRenderHint(QPainter::Antialiasing);
-                p.drawLine(QLineF(i_cross_r.topLeft(), i_cross_r.bottomRight()));
-                p.drawLine(QLineF(i_cross_r.bottomLeft(), i_cross_r.topRight()));
-                p.restore();
-            }
+            draw_text(text_pos, tag);
         }
     }
 
+    template <std::ranges::input_range Range>
+    static void drawTags(QPainter& p, Range&& tags, StyleConfig const& style, QFontMetrics const& fm,
+                         QPoint const& offset, bool has_cross) {
+        drawTags(p, tags, style, fm, offset, has_cross,
+                 [&p](QPointF const& pos, Tag const& tag) { p.drawText(pos, tag.text); });
+    }
+
     template <std::ranges::input_range Range>
     void drawTags(QPainter& p, Range&& tags, QFontMetrics const& fm, QPoint const& offset,
                   bool has_cross = true) const {
@@ -147,8 +216,132 @@ struct State {
     int select_size{0};
     QTextLayout text_layout;
     std::unique_ptr<QCompleter> completer{new QCompleter{}};
+    std::shared_ptr<SharedCompletions const> completions{std::make_shared<SharedCompletions>()};
+    std::shared_ptr<CompletionUsage> usage{std::make_shared<CompletionUsage>()};
+    std::unique_ptr<AsyncCompletion> async_completion;
     std::chrono::steady_clock::time_point focused_at{};
 
+    /// Change of the tags as listed by `getTags`, for the listeners
+    struct TagsChange {
+        enum Kind { inserted, removed, modified, committed } kind;
+        size_t pos;
+        QStringList texts;
+    };
+
+    /// Changes not emitted yet, in order, each position accounts for the ones before
+    std::vector<TagsChange> changes;
+
+    /// The editor as the listeners know it
+    struct {
+        bool listed{false};
+        QString text;
+    } reported_editor;
+
+    /// List model mirrored by the tags, see `Common::bindModel`
+    QPointer<QAbstractItemModel> model;
+    int model_column{0};
+    std::vector<QMetaObject::Connection> model_connections;
+    /// Sorted rows of the model the tags leave out, empty or duplicate ones. The other rows map to the tags in order.
+    std::vector<int> unlisted_rows;
+    /// Set while the tags and the model are brought in line, so neither echoes the other
+    bool syncing_model{false};
+
+    /// Multiset of the texts of all the tags but the editor, see `Common::countText`
+    std::unordered_map<QString, size_t> text_counts;
+
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    /// Tags in `[dirty_begin, dirty_end)` need to be measured and placed again. The ones past the range keep their
+    /// sizes and only move. The layout is clean when `dirty_begin == npos`.
+    size_t dirty_begin{0};
+    size_t dirty_end{npos};
+
+    /// End of the tags having their rects while `relayout` stops short of the end for its `bottom`, `npos` once all of
+    /// them are laid out. Kept apart from the dirty range, which also covers the laid out tags to be placed again.
+    size_t laid_out_end{0};
+
+    /// Bumped by every change of the tags or of their measurements, not by the ones of where they are laid out
+    size_t content_generation{0};
+
+    /// Everything the layout depends on apart from the tags and the style
+    struct LayoutParams {
+        QPoint origin;
+        std::optional<QRect> fit;
+        QFontMetrics fm;
+        bool has_cross;
+
+        bool operator==(LayoutParams const& rhs) const {
+            return origin == rhs.origin && fit == rhs.fit && fm == rhs.fm && has_cross == rhs.has_cross;
+        }
+    };
+
+    std::optional<LayoutParams> layout_params;
+
+    /// Text widths of the committed tags, measured with `measured_with`
+    std::unordered_map<QString, int> text_widths;
+    std::optional<QFontMetrics> measured_with;
+
+    /// `pill_sums[i]` sums the advances of the pills before `i`, as `placeRect` makes them, for `pill_sums_generation`.
+    /// A hidden editor counts 0.
+    std::vector<std::int64_t> pill_sums;
+    size_t pill_sums_generation{npos};
+
+    /// Texts of the committed tags prepared for drawing
+    std::unordered_map<QString, QStaticText> static_texts;
+
+    bool layoutDirty() const {
+        return dirty_begin != npos;
+    }
+
+    void invalidateLayout() {
+        ++content_generation;
+        dirty_begin = 0;
+        dirty_end = npos;
+        laid_out_end = 0;
+    }
+
+    /// To be called when the font or the style change
+    void invalidateMeasurements() {
+        text_widths.clear();
+        static_texts.clear();
+        invalidateLayout();
+    }
+
+    void markDirty(size_t begin, size_t end) {
+        ++content_generation;
+        dirty_begin = std::min(dirty_begin, begin);
+        dirty_end = std::max(dirty_end, end);
+    }
+
+    void markDirty(size_t i) {
+        markDirty(i, i + 1);
+    }
+
+    void markClean() {
+        dirty_begin = npos;
+        dirty_end = 0;
+    }
+
+    /// Keeps the dirty range in sync with `tags.insert(i)`
+    void tagInserted(size_t i) {
+        if (i < dirty_end && dirty_end != npos) {
+            ++dirty_end;
+        }
+        laid_out_end = std::min(laid_out_end, i); // the new tag has no rect yet
+        markDirty(i, i + 1);
+    }
+
+    /// Keeps the dirty range in sync with `tags.erase(i)`
+    void tagErased(size_t i) {
+        if (i < dirty_end && dirty_end != npos) {
+            --dirty_end;
+        }
+        if (i < laid_out_end && laid_out_end != npos) {
+            --laid_out_end;
+        }
+        markDirty(i, i);
+    }
+
     QRect const& editorRect() const {
         return tags[editing_index].rect;
     }
@@ -174,6 +367,8 @@ struct State {
     }
 
     void setCursorVisible(bool visible, QObject* ifce) {
+        auto const was_blinking = blink_timer != 0;
+
         if (blink_timer) {
             ifce->killTimer(blink_timer);
             blink_timer = 0;
@@ -188,6 +383,10 @@ struct State {
         } else {
             blink_status = false;
         }
+
+        if ((blink_timer != 0) != was_blinking) {
+            markDirty(editing_index); // the editor might appear or disappear
+        }
     }
 
     QVector<QTextLayout::FormatRange> formatting(QPalette const& palette) const {
@@ -203,7 +402,7 @@ struct State {
         return {selection};
     }
 
-    qreal cursorToX() {
+    qreal cursorToX() const {
         return text_layout.lineAt(0).cursorToX(cursor);
     }
 
@@ -249,18 +448,433 @@ struct State {
             editorText().remove(--cursor, 1);
         }
     }
+};
+
+struct Common : Style, Behavior, State {
+    ~Common() {
+        releaseTexts();
+    }
+
+    /// Counts `text`, returns the copy to store in the tag: the one counted already or, when `intern_tags`, the pooled
+    /// one. Each counted text holds a reference of the pool.
+    QString countText(QString const& text) {
+        if (auto const it = text_counts.find(text); it != text_counts.end()) {
+            ++it->second;
+            return it->first;
+        }
+        return text_counts.emplace(intern_tags ? StringPool::global().intern(text) : text, 1).first->first;
+    }
+
+    void uncountText(QString const& text) {
+        auto const it = text_counts.find(text);
+        assert(it != text_counts.end());
+        if (--it->second == 0) {
+            if (intern_tags) {
+                StringPool::global().release(it->first);
+            }
+            text_counts.erase(it);
+        }
+    }
+
+    /// Empties `text_counts`, releasing the pooled texts
+    void releaseTexts() {
+        if (intern_tags) {
+            for (auto const& x : text_counts) {
+                StringPool::global().release(x.first);
+            }
+        }
+        text_counts.clear();
+    }
+
+    void recountTexts() {
+        releaseTexts();
+        for (auto const i : std::views::iota(size_t{0}, tags.size())) {
+            if (i != editing_index) {
+                tags[i].text = countText(tags[i].text);
+            }
+        }
+    }
+
+    /// Sets `intern_tags`, moving the texts of the tags in or out of the pool
+    void internTags(bool intern) {
+        if (intern_tags != intern) {
+            releaseTexts();
+            intern_tags = intern;
+            recountTexts();
+        }
+    }
 
     void removeDuplicates() {
-        everload_tags::removeDuplicates(tags);
-        auto const it = std::find_if(tags.begin(), tags.end(), [](auto const& x) {
-            return x.text.isEmpty(); // Thanks to Invariant-1 we can track back the editing_index.
+        everload_tags::removeDuplicates(tags, editing_index);
+        invalidateLayout();
+        recountTexts();
+    }
+
+    /// Whether the editor takes place in the layout
+    bool editorLaidOut() const {
+        return cursorVisible() || !editorText().isEmpty();
+    }
+
+    /// Top-left of the spot following the laid out tags in `[0, i)`
+    QPoint topLeftAfter(size_t i, QPoint const& origin) const {
+        while (i-- > 0) {
+            if (i != editing_index || editorLaidOut()) {
+                return {tags[i].rect.right() + pills_h_spacing, tags[i].rect.top()};
+            }
+        }
+        return origin;
+    }
+
+    /// Drops the measurements unless they were made with `fm`
+    void measureWith(QFontMetrics const& fm) {
+        if (!measured_with || !(*measured_with == fm)) {
+            text_widths.clear();
+            static_texts.clear();
+            ++content_generation;
+            measured_with = fm;
+        }
+    }
+
+    /// Least texts worth measuring on several threads, see `measureTexts`
+    static constexpr size_t min_parallel_measurement = 4096;
+
+    /// With `parallel_measurement`, measures the texts of the tags missing from `text_widths` on worker threads,
+    /// each with its own `QFontMetrics` of `font` since they are not thread-safe. The next `relayout` finds them
+    /// measured. Fewer than `min_parallel_measurement` texts are left to `relayout`.
+    void measureTexts(QFont const& font, QFontMetrics const& fm) {
+        if (!parallel_measurement) {
+            return;
+        }
+        measureWith(fm);
+
+        std::vector<std::pair<QString, int*>> jobs;
+        for (size_t i = 0; i < tags.size(); ++i) {
+            if (i == editing_index) {
+                continue;
+            }
+            auto const [it, inserted] = text_widths.try_emplace(tags[i].text, 0);
+            if (inserted) {
+                jobs.emplace_back(tags[i].text, &it->second); // references to the elements survive rehashing
+            }
+        }
+        if (jobs.size() < min_parallel_measurement) {
+            for (auto& [text, width] : jobs) {
+                *width = FONT_METRICS_WIDTH(fm, text);
+            }
+            return;
+        }
+
+        auto const threads = static_cast<size_t>(std::max(QThread::idealThreadCount(), 1));
+        auto const chunk = (jobs.size() + threads - 1) / threads;
+        std::vector<std::jthread> workers;
+        for (size_t begin = 0; begin < jobs.size(); begin += chunk) {
+            workers.emplace_back([&font, range = std::span(jobs).subspan(begin, std::min(chunk, jobs.size() - begin))] {
+                QFontMetrics const thread_fm(font);
+                for (auto& [text, width] : range) {
+                    *width = FONT_METRICS_WIDTH(thread_fm, text);
+                }
+            });
+        }
+    }
+
+    int textWidth(size_t i, QFontMetrics const& fm) {
+        if (i == editing_index) { // changes on every key press, not worth caching
+            return FONT_METRICS_WIDTH(fm, tags[i].text);
+        }
+        auto const [it, inserted] = text_widths.try_emplace(tags[i].text, 0);
+        if (inserted) {
+            it->second = FONT_METRICS_WIDTH(fm, tags[i].text);
+        }
+        return it->second;
+    }
+
+    /// Recalculates the rects of the dirty tags. The following tags are only moved, until one of them lands on its
+    /// previous spot, since from there on the rows line up with the previous layout.
+    /// \param bottom Stop at the first row starting below. The tags left, the editor among them maybe, are kept dirty,
+    /// see `laidOutEnd`.
+    /// \returns top-left of the spot following the last laid out tag
+    QPoint relayout(QPoint const& origin, QFontMetrics const& fm, std::optional<QRect> const& fit, bool has_cross,
+                    int bottom = std::numeric_limits<int>::max()) {
+        measureWith(fm);
+        LayoutParams params{origin, fit, fm, has_cross};
+        if (!layout_params || !(*layout_params == params)) {
+            layout_params = std::move(params);
+            // Only the places change
+            dirty_begin = 0;
+            dirty_end = npos;
+        }
+
+        if (text_widths.size() > 2 * tags.size()) { // mostly removed tags
+            text_widths.clear();
+        }
+
+        if (static_texts.size() > 2 * tags.size()) {
+            static_texts.clear();
+        }
+
+        if (!layoutDirty()) {
+            return topLeftAfter(tags.size(), origin);
+        }
+
+        auto const height = pillHeight(fm.height());
+        auto lt = topLeftAfter(dirty_begin, origin);
+
+        for (auto i = dirty_begin; i < tags.size(); ++i) {
+            auto& tag = tags[i];
+
+            if (bottom < lt.y()) {
+                dirty_begin = i;
+                dirty_end = npos;
+                laid_out_end = i;
+                return lt;
+            }
+
+            if (i == editing_index && !editorLaidOut()) {
+                tag.rect = QRect(lt, QSize(0, height)); // keeps the rects ordered
+                continue;
+            }
+
+            auto const dirty = i < dirty_end;
+            auto const size = dirty ? QSize(pillWidth(textWidth(i, fm), has_cross), height) : tag.rect.size();
+            auto const rect = placeRect(lt, size, *this, fit);
+
+            if (!dirty && rect == tag.rect) {
+                break;
+            }
+
+            tag.rect = rect;
+        }
+
+        markClean();
+        laid_out_end = npos;
+        return topLeftAfter(tags.size(), origin);
+    }
+
+    /// End of the tags having their rects, all of them unless `relayout` stopped short
+    size_t laidOutEnd() const {
+        return std::min(laid_out_end, tags.size());
+    }
+
+    /// Whether the editor has its rect, it might be past the point where `relayout` stopped
+    bool editorPlaced() const {
+        return editing_index < laidOutEnd();
+    }
+
+    /// Bottom of the last row, extrapolated from the tags per row laid out so far when the layout stopped short
+    int estimatedBottom(QPoint const& origin, int height) const {
+        auto const laid = laidOutEnd();
+        return extrapolatedBottom(origin.y(), laid, laid == 0 ? origin.y() : tags[laid - 1].rect.top(), height);
+    }
+
+    /// Bottom of the last row, given that the first `laid` tags fill the rows from `top` to `last_top`
+    int extrapolatedBottom(int top, size_t laid, int last_top, int height) const {
+        auto const row = height - 1 + tag_v_spacing; // see `placeRect`
+        if (laid == 0) {
+            return top + static_cast<int>(tags.size()) * row - tag_v_spacing - 1;
+        }
+        auto const rows = static_cast<size_t>((last_top - top) / row + 1);
+        auto const rows_left = ((tags.size() - laid) * rows + laid - 1) / laid;
+        return last_top + height - 1 + static_cast<int>(rows_left) * row;
+    }
+
+    /// Bottom of the tags if they were laid out in `fit`, leaves their rects as they are. Every row is found by binary
+    /// search over `pill_sums`, so a new width costs O(rows log n).
+    /// \param bottom Extrapolate past the first row starting below, see `relayout`. Then the tags are walked, only
+    /// the ones above are measured.
+    int bottomFor(QRect const& fit, QFontMetrics const& fm, bool has_cross,
+                  int bottom = std::numeric_limits<int>::max()) {
+        auto const height = pillHeight(fm.height());
+        measureWith(fm);
+
+        if (bottom == std::numeric_limits<int>::max()) {
+            updatePillSums(fm, has_cross);
+            int rows = 0;
+            for (size_t i = 0; i < tags.size(); i = rowEnd(i, fit.width())) {
+                ++rows;
+            }
+            return fit.top() + std::max(rows - 1, 0) * (height - 1 + tag_v_spacing) + height - 1;
+        }
+
+        auto lt = fit.topLeft();
+        for (size_t i = 0; i < tags.size(); ++i) {
+            if (i == editing_index && !editorLaidOut()) {
+                continue;
+            }
+            if (bottom < lt.y()) {
+                return extrapolatedBottom(fit.top(), i, lt.y(), height);
+            }
+            placeRect(lt, QSize(pillWidth(textWidth(i, fm), has_cross), height), *this, fit);
+        }
+        return lt.y() + height - 1;
+    }
+
+    void updatePillSums(QFontMetrics const& fm, bool has_cross) {
+        if (pill_sums_generation == content_generation) {
+            return;
+        }
+        pill_sums.resize(tags.size() + 1);
+        pill_sums[0] = 0;
+        for (size_t i = 0; i < tags.size(); ++i) {
+            auto const hidden = i == editing_index && !editorLaidOut();
+            auto const advance = hidden ? 0 : pillWidth(textWidth(i, fm), has_cross) - 1 + pills_h_spacing;
+            pill_sums[i + 1] = pill_sums[i] + advance;
+        }
+        pill_sums_generation = content_generation;
+    }
+
+    /// End of the row starting with the tag `i` when wrapping at `width`, like `placeRect` does: the tags fitting, or
+    /// the first one alone when even it doesn't
+    size_t rowEnd(size_t i, int width) const {
+        // The pills in [i, j) span `pill_sums[j] - pill_sums[i] - pills_h_spacing + 1`, they fit when that is at most
+        // `width`
+        auto const limit = pill_sums[i] + width - 1 + pills_h_spacing;
+        auto const it = std::upper_bound(pill_sums.begin() + static_cast<ptrdiff_t>(i) + 1, pill_sums.end(), limit);
+        auto const end = static_cast<size_t>(it - pill_sums.begin()) - 1;
+        auto first = i; // skip the hidden editor
+        while (first + 1 < tags.size() && pill_sums[first + 1] == pill_sums[first]) {
+            ++first;
+        }
+        return std::max(end, first + 1);
+    }
+
+    QStaticText const& staticText(QString const& text, QFont const& font) {
+        auto const [it, inserted] = static_texts.try_emplace(text);
+        if (inserted) {
+            it->second.setTextFormat(Qt::PlainText);
+            it->second.setText(text);
+            it->second.prepare(QTransform(), font);
+        }
+        return it->second;
+    }
+
+    /// Draws the tags with their prepared texts
+    template <std::ranges::input_range Range>
+    void drawTags(QPainter& p, Range&& tags, QFontMetrics const& fm, QPoint const& offset, bool has_cross) {
+        Style::drawTags(p, tags, *this, fm, offset, has_cross, [&](QPointF const& pos, Tag const& tag) {
+            p.drawStaticText(pos - QPointF(0, fm.ascent()), staticText(tag.text, p.font()));
         });
-        assert(it != tags.end());
-        editing_index = static_cast<size_t>(std::distance(tags.begin(), it));
     }
-};
 
-struct Common : Style, Behavior, State {
+    /// Indices `[first, last)` of the tags in the rows spanned by `r`, narrowed down to the columns spanned by `r` when
+    /// it is a single row. Found by binary search thanks to the rects being ordered by rows, then by columns.
+    std::pair<size_t, size_t> tagsSpanning(QRect const& r) const {
+        auto const laid = std::ranges::subrange(tags.begin(), tags.begin() + static_cast<ptrdiff_t>(laidOutEnd()));
+        auto first = std::ranges::partition_point(laid, [&](auto const& x) { return x.rect.bottom() < r.top(); });
+        auto last =
+            std::ranges::partition_point(first, laid.end(), [&](auto const& x) { return x.rect.top() <= r.bottom(); });
+
+        if (first != last && first->rect.top() == std::prev(last)->rect.top()) {
+            first = std::ranges::partition_point(first, last, [&](auto const& x) { return x.rect.right() < r.left(); });
+            last = std::ranges::partition_point(first, last, [&](auto const& x) { return x.rect.left() <= r.right(); });
+        }
+
+        return {static_cast<size_t>(first - tags.begin()), static_cast<size_t>(last - tags.begin())};
+    }
+
+    /// Index of the tag under `pos`
+    std::optional<size_t> tagAt(QPoint const& pos) const {
+        auto const [first, last] = tagsSpanning(QRect(pos, QSize(1, 1)));
+        for (auto i = first; i < last; ++i) {
+            if (tags[i].rect.contains(pos)) {
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+
+    /// Index for a new tag at `pos`: before the first tag right of `pos` in the row of `pos` or the next row
+    size_t insertionIndex(QPoint const& pos) const {
+        auto const laid = std::ranges::subrange(tags.begin(), tags.begin() + static_cast<ptrdiff_t>(laidOutEnd()));
+        auto const first = std::ranges::partition_point(laid, [&](auto const& x) { return x.rect.bottom() < pos.y(); });
+        if (first == laid.end()) {
+            return laid.size();
+        }
+        auto const row = first->rect.top();
+        auto const row_end =
+            std::ranges::partition_point(first, laid.end(), [&](auto const& x) { return x.rect.top() == row; });
+        auto const it =
+            std::ranges::partition_point(first, row_end, [&](auto const& x) { return x.rect.left() < pos.x(); });
+        return static_cast<size_t>(it - tags.begin());
+    }
+
+    /// Area of the blinking cursor
+    QRect cursorRect() const {
+        auto const& r = editorRect();
+        auto const x = r.left() + pill_thickness.left() + qRound(cursorToX());
+        return QRect(x - 2, r.top(), 5, r.height());
+    }
+
+    /// Number of completions offered at once
+    static constexpr size_t max_completions = 100;
+
+    void setupCompleterModel() {
+        completer->setModel(new QStringListModel(completer.get()));
+        completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    }
+
+    void setCompletions(std::shared_ptr<SharedCompletions const> vocabulary) {
+        async_completion.reset();
+        completions = vocabulary ? std::move(vocabulary) : std::make_shared<SharedCompletions>();
+    }
+
+    void setCompletionProvider(CompletionProvider provider, std::chrono::milliseconds delay) {
+        setCompletions(nullptr);
+        if (provider) {
+            async_completion = std::make_unique<AsyncCompletion>(
+                std::move(provider), delay, completer.get(),
+                [this](QString const& prefix, QStringList const& results) {
+                    // Moving to another tag does not go through `complete`
+                    if (prefix == editorText()) {
+                        auto ranked = results;
+                        usage->rank(ranked);
+                        offerCompletions(ranked);
+                    }
+                });
+        }
+    }
+
+    void offerCompletions(QStringList const& completions) {
+        static_cast<QStringListModel*>(completer->model())->setStringList(completions);
+        completer->setCompletionPrefix(editorText());
+        completer->complete();
+    }
+
+    /// Most used tags first, then the vocabulary in order
+    QStringList completePrefix() const {
+        auto ret = usage->top(editorText(), max_completions);
+        std::unordered_set<QString> const used(ret.begin(), ret.end());
+        for (auto const& x : completions->complete(editorText(), max_completions + used.size())) {
+            if (static_cast<size_t>(ret.size()) == max_completions) {
+                break;
+            }
+            if (!used.contains(x)) {
+                ret.push_back(x);
+            }
+        }
+        return ret;
+    }
+
+    /// Best matches, the most used first
+    QStringList completeFuzzy() const {
+        auto ret = completions->completeFuzzy(editorText(), max_completions);
+        usage->rank(ret);
+        return ret;
+    }
+
+    /// Space commits the editor text, `setEditorIndex` counts its use
+    void commitEditorText() {
+        editNewTag(editing_index + 1);
+    }
+
+    /// Offers the completions of the editor text, the popup filters nothing
+    void complete() {
+        if (async_completion) {
+            async_completion->request(editorText());
+        } else {
+            offerCompletions(fuzzy_completion ? completeFuzzy() : completePrefix());
+        }
+    }
+
     void drawEditor(QPainter& p, QPalette const& palette, QPoint const& offset) const {
         auto const& r = editorRect();
         auto const& txt_p = r.topLeft() + QPointF(pill_thickness.left(), pill_thickness.top());
@@ -278,32 +892,42 @@ struct Common : Style, Behavior, State {
 
     bool isCurrentTagADuplicate() const {
         assert(editing_index < tags.size());
-        auto const mid = tags.begin() + static_cast<std::ptrdiff_t>(editing_index);
-        auto const text_eq = [this](auto const& x) { return x.text == editorText(); };
-        return std::find_if(tags.begin(), mid, text_eq) != mid ||
-               std::find_if(mid + 1, tags.end(), text_eq) != tags.end();
+        return text_counts.contains(editorText());
     }
 
     /// Makes the tag at `i` currently editing, and ensures Invariant-1 and Invariant-2`.
-    void setEditorIndex(size_t i) {
+    /// \param new_tag `i` was just inserted by `editNewTag`, the listeners don't know of it
+    void setEditorIndex(size_t i, bool new_tag = false) {
         assert(i < tags.size());
-        if (editorText().isEmpty() || (unique && isCurrentTagADuplicate())) {
+        noteEditor();
+        if (!editorListed()) {
             tags.erase(std::next(begin(tags), static_cast<std::ptrdiff_t>(editing_index)));
+            tagErased(editing_index);
             if (editing_index <= i) { // Did we shift `i`?
                 --i;
             }
+        } else {
+            editorText() = countText(editorText());
+            usage->record(editorText());
+            auto const pos = editing_index - (new_tag && i < editing_index ? 1 : 0);
+            changes.push_back({TagsChange::committed, pos, {editorText()}});
         }
         editing_index = i;
+        uncountText(editorText());
+        reported_editor = {editorListed(), editorText()};
     }
 
     // Inserts a new tag at `i`, makes the tag currently editing, and ensures Invariant-1.
     void editNewTag(size_t i) {
         assert(i <= tags.size());
+        noteEditor(); // while the positions are the ones the listeners know
         tags.insert(begin(tags) + static_cast<std::ptrdiff_t>(i), Tag{});
+        tagInserted(i);
+        countText({}); // not the editor yet
         if (i <= editing_index) { // Did we shift `editing_index`?
             ++editing_index;
         }
-        setEditorIndex(i);
+        setEditorIndex(i, true);
         moveCursor(0, false);
     }
 
@@ -328,32 +952,382 @@ struct Common : Style, Behavior, State {
     }
 
     void removeTag(size_t i) {
+        noteEditor();
+        if (i != editing_index || reported_editor.listed) {
+            auto const hidden_before = !reported_editor.listed && editing_index < i;
+            changes.push_back({TagsChange::removed, i - (hidden_before ? 1 : 0), {tags[i].text}});
+        }
+        auto const editor_removed = i == editing_index;
+        if (!editor_removed) {
+            uncountText(tags[i].text);
+        }
         tags.erase(tags.begin() + static_cast<ptrdiff_t>(i));
-        if (i <= editing_index) {
+        tagErased(i);
+        if (editor_removed && i == 0) { // the next tag becomes the editor, or a new empty one
+            if (tags.empty()) {
+                tags.push_back(Tag{});
+                tagInserted(0);
+            }
+        } else if (i <= editing_index) {
             --editing_index;
         }
+        if (editor_removed) {
+            if (!editorText().isEmpty()) { // a committed tag, not the new one
+                uncountText(editorText());
+            }
+            reported_editor = {editorListed(), editorText()};
+            moveCursor(0, false);
+        }
     }
 
     void setTags(std::ranges::forward_range auto const& tags) {
-        std::unordered_set<QString> unique_tags;
+        releaseTexts();
         std::vector<Tag> t;
         for (auto const& x : tags) {
-            if (/* Invariant-1 */ !x.isEmpty() && /* Invariant-2 */ (!unique || unique_tags.insert(x).second)) {
-                t.emplace_back(x, QRect{});
+            if (/* Invariant-1 */ x.isEmpty() || (/* Invariant-2 */ unique && text_counts.contains(x))) {
+                continue;
             }
+            t.emplace_back(countText(x), QRect{});
         }
         this->tags = std::move(t);
         this->tags.push_back(Tag{});
         editing_index = this->tags.size() - 1;
+        invalidateLayout();
         moveCursor(0, false);
+        forgetChanges();
+        if (model && !syncing_model) {
+            writeAllToModel();
+        }
+    }
+
+    /// Replaces `count` tags from `pos` by `texts`, the positions are the ones of `getTags`.
+    /// Skips the texts breaking Invariant-1 or Invariant-2. Marks dirty only the layout from `pos` on.
+    /// \param accepted Gets whether each text was kept
+    void replaceTags(size_t pos, size_t count, std::ranges::input_range auto const& texts,
+                     std::vector<bool>* accepted = nullptr) {
+        noteEditor();
+        auto const listed = editorListed();
+        auto const size = listedSize();
+        pos = std::min(pos, size);
+        count = std::min(count, size - pos);
+        auto const was_dirty = layoutDirty();
+
+        if (count != 0) {
+            QStringList removed;
+            for (auto i = pos; i < pos + count; ++i) {
+                removed.push_back(tags[listed || i < editing_index ? i : i + 1].text);
+            }
+            changes.push_back({TagsChange::removed, pos, std::move(removed)});
+        }
+
+        // Splice the tags without the editor, it is put back after
+        auto editor = std::move(tags[editing_index]);
+        tags.erase(tags.begin() + static_cast<std::ptrdiff_t>(editing_index));
+        auto const committed = [&](size_t i) { return listed && i > editing_index ? i - 1 : i; };
+        auto const b = committed(pos);
+        auto const e = committed(pos + count);
+
+        for (auto i = b; i < e; ++i) {
+            uncountText(tags[i].text);
+        }
+        std::vector<Tag> inserted;
+        for (auto const& x : texts) {
+            auto const skip = /* Invariant-1 */ x.isEmpty() || (/* Invariant-2 */ unique && text_counts.contains(x));
+            if (accepted) {
+                accepted->push_back(!skip);
+            }
+            if (skip) {
+                continue;
+            }
+            inserted.push_back(Tag{countText(x), QRect{}});
+        }
+        if (!inserted.empty()) {
+            QStringList added;
+            for (auto const& x : inserted) {
+                added.push_back(x.text);
+            }
+            changes.push_back({TagsChange::inserted, pos, std::move(added)});
+        }
+        auto const it = tags.erase(tags.begin() + static_cast<std::ptrdiff_t>(b),
+                                   tags.begin() + static_cast<std::ptrdiff_t>(e));
+        tags.insert(it, std::make_move_iterator(inserted.begin()), std::make_move_iterator(inserted.end()));
+        auto const inserted_end = b + inserted.size();
+
+        auto const editor_removed = listed && pos <= editing_index && editing_index < pos + count;
+        if (editor_removed) {
+            editor = Tag{};
+            editing_index = inserted_end;
+            reported_editor = {};
+        } else if (pos + count <= editing_index) {
+            editing_index = editing_index - (e - b) + inserted.size();
+        } else if (pos < editing_index) { // A hidden editor amid the replaced tags
+            editing_index = inserted_end;
+        }
+        tags.insert(tags.begin() + static_cast<std::ptrdiff_t>(editing_index), std::move(editor));
+
+        size_t const shift = editing_index <= b ? 1 : 0; // The editor went in before the inserted
+        if (was_dirty) {
+            markDirty(std::min(b, editing_index), npos);
+        } else {
+            markDirty(b + shift, inserted_end + shift);
+            markDirty(editing_index);
+        }
+        if (editor_removed) {
+            moveCursor(0, false);
+        }
+    }
+
+    /// Whether `getTags` lists the editor
+    bool editorListed() const {
+        return !editorText().isEmpty() && !(unique && isCurrentTagADuplicate());
+    }
+
+    /// Size of `getTags`
+    size_t listedSize() const {
+        return tags.size() - (editorListed() ? 0 : 1);
+    }
+
+    /// Records how the editor changed since the listeners last heard of it
+    void noteEditor() {
+        auto const listed = editorListed();
+        if (listed && !reported_editor.listed) {
+            changes.push_back({TagsChange::inserted, editing_index, {editorText()}});
+        } else if (!listed && reported_editor.listed) {
+            changes.push_back({TagsChange::removed, editing_index, {reported_editor.text}});
+        } else if (listed && reported_editor.text != editorText()) {
+            changes.push_back({TagsChange::modified, editing_index, {editorText()}});
+        }
+        reported_editor = {listed, editorText()};
+    }
+
+    /// Mirrors the rows of a list model column: the tags follow the model and the edits are written back.
+    /// \param context Receiver of the model signals
+    /// \param changed Relayouts and emits the changes, after the model changed the tags
+    void bindModel(QObject* context, QAbstractItemModel* m, int column, std::function<void()> changed) {
+        for (auto const& x : std::exchange(model_connections, {})) {
+            QObject::disconnect(x);
+        }
+        model = m;
+        model_column = column;
+        if (!model) {
+            return;
+        }
+        syncing_model = true;
+        readAllFromModel();
+        syncing_model = false;
+
+        // Applies `f` unless the model change is our own write
+        auto const follow = [this, changed](auto f) {
+            if (syncing_model) {
+                return;
+            }
+            syncing_model = true;
+            f();
+            // Only when a listener of the model changed the tags as well, the rows no longer map to them
+            if (listedSize() + unlisted_rows.size() != static_cast<size_t>(model->rowCount())) {
+                readAllFromModel();
+            }
+            changed();
+            syncing_model = false;
+        };
+        auto const reset = [this, follow] { follow([this] { readAllFromModel(); }); };
+        model_connections = {
+            QObject::connect(m, &QAbstractItemModel::rowsInserted, context,
+                             [this, follow](QModelIndex const& parent, int first, int last) {
+                                 if (!parent.isValid()) {
+                                     follow([&] {
+                                         shiftUnlistedRows(first, last - first + 1);
+                                         readFromModel(first, last + 1, 0);
+                                     });
+                                 }
+                             }),
+            QObject::connect(m, &QAbstractItemModel::rowsRemoved, context,
+                             [this, follow](QModelIndex const& parent, int first, int last) {
+                                 if (!parent.isValid()) {
+                                     follow([&] {
+                                         auto const pos = positionOfRow(first);
+                                         auto const count = positionOfRow(last + 1) - pos;
+                                         shiftUnlistedRows(first, first - last - 1);
+                                         replaceTags(pos, count, QStringList{});
+                                     });
+                                 }
+                             }),
+            QObject::connect(m, &QAbstractItemModel::dataChanged, context,
+                             [this, follow](QModelIndex const& top_left, QModelIndex const& bottom_right) {
+                                 if (top_left.parent().isValid() || model_column < top_left.column() ||
+                                     bottom_right.column() < model_column) {
+                                     return;
+                                 }
+                                 auto const first = top_left.row();
+                                 auto const last = bottom_right.row() + 1;
+                                 follow([&] {
+                                     auto const count = positionOfRow(last) - positionOfRow(first);
+                                     std::erase_if(unlisted_rows, [&](int x) { return first <= x && x < last; });
+                                     readFromModel(first, last, count);
+                                 });
+                             }),
+            QObject::connect(m, &QAbstractItemModel::rowsMoved, context, reset),
+            QObject::connect(m, &QAbstractItemModel::modelReset, context, reset),
+            QObject::connect(m, &QAbstractItemModel::layoutChanged, context, reset),
+        };
+    }
+
+    /// Texts of the rows [first, last) of the model column
+    QStringList modelTexts(int first, int last) const {
+        QStringList ret;
+        for (auto row = first; row < last; ++row) {
+            ret.push_back(model->index(row, model_column).data(Qt::EditRole).toString());
+        }
+        return ret;
+    }
+
+    /// Replaces the tags by the rows of the model
+    void readAllFromModel() {
+        auto const texts = modelTexts(0, model->rowCount());
+        setTags(texts);
+        // The rows `setTags` leaves out, by the same rules
+        unlisted_rows.clear();
+        std::unordered_set<QString> seen;
+        for (auto row = 0; row < static_cast<int>(texts.size()); ++row) {
+            if (texts[row].isEmpty() || (!seen.insert(texts[row]).second && unique)) {
+                unlisted_rows.push_back(row);
+            }
+        }
+    }
+
+    /// Replaces the `count` tags of the rows from `first` by the rows [first, last), which aren't in `unlisted_rows`
+    void readFromModel(int first, int last, size_t count) {
+        std::vector<bool> accepted;
+        replaceTags(positionOfRow(first), count, modelTexts(first, last), &accepted);
+        for (auto row = first; row < last; ++row) {
+            if (!accepted[static_cast<size_t>(row - first)]) {
+                unlisted_rows.insert(std::ranges::lower_bound(unlisted_rows, row), row);
+            }
+        }
+    }
+
+    /// Position in `getTags` of the tag of the model `row`, or of the tag after it when the row is unlisted
+    size_t positionOfRow(int row) const {
+        auto const unlisted_before = std::ranges::lower_bound(unlisted_rows, row) - unlisted_rows.begin();
+        return static_cast<size_t>(row - unlisted_before);
+    }
+
+    /// Model row of the tag at `pos` in `getTags`, the row count past the last tag
+    int rowOfPosition(size_t pos) const {
+        auto row = static_cast<int>(pos);
+        for (auto const x : unlisted_rows) {
+            if (row < x) {
+                break;
+            }
+            ++row;
+        }
+        return row;
+    }
+
+    /// Keeps `unlisted_rows` in line with `n` rows inserted at `row`, or `-n` rows removed there
+    void shiftUnlistedRows(int row, int n) {
+        if (n < 0) {
+            std::erase_if(unlisted_rows, [&](int x) { return row <= x && x < row - n; });
+        }
+        for (auto& x : unlisted_rows) {
+            if (row <= x) {
+                x += n;
+            }
+        }
+    }
+
+    /// Replaces the rows of the model by `getTags`
+    void writeAllToModel() {
+        syncing_model = true;
+        unlisted_rows.clear();
+        QStringList texts;
+        getTags(texts);
+        model->removeRows(0, model->rowCount());
+        if (model->insertRows(0, static_cast<int>(texts.size()))) {
+            for (auto i = 0; i < static_cast<int>(texts.size()); ++i) {
+                model->setData(model->index(i, model_column), texts[i]);
+            }
+        }
+        syncing_model = false;
+    }
+
+    void writeToModel(TagsChange const& x) {
+        syncing_model = true;
+        auto const row = rowOfPosition(x.pos);
+        auto const n = static_cast<int>(x.texts.size());
+        switch (x.kind) {
+        case TagsChange::inserted:
+            if (model->insertRows(row, n)) {
+                shiftUnlistedRows(row, n);
+                for (auto i = 0; i < n; ++i) {
+                    model->setData(model->index(row + i, model_column), x.texts[i]);
+                }
+            }
+            break;
+        case TagsChange::removed:
+            // Backwards in runs of adjacent rows, the unlisted rows amid the tags stay
+            for (auto i = x.texts.size(); i-- > 0;) {
+                auto const last = rowOfPosition(x.pos + i);
+                auto first = last;
+                while (i > 0 && rowOfPosition(x.pos + i - 1) == first - 1) {
+                    --i;
+                    --first;
+                }
+                if (model->removeRows(first, last - first + 1)) {
+                    shiftUnlistedRows(first, first - last - 1);
+                }
+            }
+            break;
+        case TagsChange::modified:
+            model->setData(model->index(row, model_column), x.texts.front());
+            break;
+        case TagsChange::committed:
+            break;
+        }
+        syncing_model = false;
+    }
+
+    /// For the changes made on behalf of the owner of the widget, like `setTags`
+    void forgetChanges() {
+        changes.clear();
+        reported_editor = {editorListed(), editorText()};
+    }
+
+    /// Emits the changes since the last call, one signal per change
+    template <class Widget>
+    void emitChanges(Widget* ifce) {
+        noteEditor();
+        for (auto& x : std::exchange(changes, {})) {
+            if (model && !syncing_model) {
+                writeToModel(x);
+            }
+            auto const pos = static_cast<int>(x.pos);
+            switch (x.kind) {
+            case TagsChange::inserted:
+                emit ifce->tagsInserted(pos, x.texts);
+                break;
+            case TagsChange::removed:
+                emit ifce->tagsRemoved(pos, x.texts);
+                break;
+            case TagsChange::modified:
+                emit ifce->tagModified(pos, x.texts.front());
+                break;
+            case TagsChange::committed:
+                emit ifce->tagCommitted(pos, x.texts.front());
+                break;
+            }
+        }
     }
 
     template <class T>
-    void getTags(T& out) {
-        out.resize(tags.size());
-        std::transform(tags.begin(), tags.end(), out.begin(), [](auto const& tag) { return tag.text; });
-        if (editorText().isEmpty() || (unique && std::count(out.begin(), out.end(), editorText()) > 1)) {
-            out.erase(out.begin() + static_cast<ptrdiff_t>(editing_index));
+    void getTags(T& out) const {
+        auto const skip = editorListed() ? tags.size() : editing_index;
+        out.clear();
+        out.reserve(listedSize());
+        for (size_t i = 0; i < tags.size(); ++i) {
+            if (i != skip) {
+                out.push_back(tags[i].text);
+            }
         }
     }
 
@@ -0,0 +1,365 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Nicolai Trandafil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <QMetaObject>
+#include <QRunnable>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <everload_tags/config.hpp>
+#include <functional>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stop_token>
+#include <vector>
+
+namespace everload_tags {
+
+/// Pattern compiled for loose, case-insensitive matching of the words it is scored against
+class FuzzyPattern {
+public:
+    /// Ordering of a match, less is better
+    struct Score {
+        enum Kind { prefix, substring, subsequence, typo } kind;
+        int errors;
+        qsizetype length;
+
+        auto operator<=>(Score const&) const = default;
+    };
+
+    /// Only the first 64 characters of `pattern` count
+    explicit FuzzyPattern(QStringView pattern) : size(std::min<qsizetype>(pattern.size(), 64)) {
+        for (qsizetype i = 0; i < size; ++i) {
+            auto const c = fold(pattern[i]);
+            folded[static_cast<size_t>(i)] = c;
+            mask(c) |= std::uint64_t{1} << i;
+        }
+        max_errors = static_cast<int>(std::min<qsizetype>(2, size / 3));
+        pattern_signature = signature(pattern.left(size));
+    }
+
+    /// Set of the characters of `word` on 64 bits, letters and digits get a bit each
+    static std::uint64_t signature(QStringView word) {
+        std::uint64_t ret = 0;
+        for (qsizetype i = 0; i < word.size(); ++i) {
+            auto const c = fold(word[i]);
+            auto const bit = c >= u'a' && c <= u'z'   ? c - u'a'
+                             : c >= u'0' && c <= u'9' ? 26 + (c - u'0')
+                                                      : 36 + c % 28;
+            ret |= std::uint64_t{1} << bit;
+        }
+        return ret;
+    }
+
+    /// Cheap rejection, every pattern character missing from the word costs at least one edit
+    bool mayMatch(std::uint64_t word_signature) const {
+        return std::popcount(pattern_signature & ~word_signature) <= max_errors;
+    }
+
+    /// Nullopt when `word` is farther than the typos tolerated for the pattern length
+    std::optional<Score> score(QStringView word) const {
+        if (size == 0) {
+            return Score{Score::prefix, 0, word.size()};
+        }
+        if (isPrefix(word)) {
+            return Score{Score::prefix, 0, word.size()};
+        }
+        auto const errors = distance(word);
+        if (errors == 0) {
+            return Score{Score::substring, 0, word.size()};
+        }
+        if (isSubsequence(word)) {
+            return Score{Score::subsequence, 0, word.size()};
+        }
+        if (errors <= max_errors) {
+            return Score{Score::typo, errors, word.size()};
+        }
+        return std::nullopt;
+    }
+
+private:
+    static char16_t fold(QChar c) {
+        auto const u = c.unicode();
+        if (u < 128) {
+            return u >= u'A' && u <= u'Z' ? static_cast<char16_t>(u + (u'a' - u'A')) : u;
+        }
+        return c.toCaseFolded().unicode();
+    }
+
+    std::uint64_t& mask(char16_t c) {
+        if (c < latin1.size()) {
+            return latin1[c];
+        }
+        auto const it = std::ranges::find(other, c, &std::pair<char16_t, std::uint64_t>::first);
+        return it != other.end() ? it->second : other.emplace_back(c, 0).second;
+    }
+
+    std::uint64_t mask(char16_t c) const {
+        if (c < latin1.size()) {
+            return latin1[c];
+        }
+        auto const it = std::ranges::find(other, c, &std::pair<char16_t, std::uint64_t>::first);
+        return it != other.end() ? it->second : 0;
+    }
+
+    /// Edit distance from the pattern to its closest substring of `word`.
+    /// Myers' bit-parallel algorithm, one step advances every pattern position at once.
+    int distance(QStringView word) const {
+        auto const high = std::uint64_t{1} << (size - 1);
+        auto pv = ~std::uint64_t{0};
+        auto mv = std::uint64_t{0};
+        auto score = static_cast<int>(size);
+        auto best = score;
+        for (qsizetype i = 0; i < word.size() && best > 0; ++i) {
+            auto const eq = mask(fold(word[i]));
+            auto const xv = eq | mv;
+            auto const xh = (((eq & pv) + pv) ^ pv) | eq;
+            auto ph = mv | ~(xh | pv);
+            auto mh = pv & xh;
+            score += (ph & high) ? 1 : (mh & high) ? -1 : 0;
+            ph <<= 1;
+            mh <<= 1;
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+            best = std::min(best, score);
+        }
+        return best;
+    }
+
+    bool isPrefix(QStringView word) const {
+        if (word.size() < size) {
+            return false;
+        }
+        for (qsizetype i = 0; i < size; ++i) {
+            if (fold(word[i]) != folded[static_cast<size_t>(i)]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool isSubsequence(QStringView word) const {
+        qsizetype j = 0;
+        for (qsizetype i = 0; i < word.size() && j < size; ++i) {
+            j += fold(word[i]) == folded[static_cast<size_t>(j)];
+        }
+        return j == size;
+    }
+
+    qsizetype size;
+    int max_errors;
+    std::uint64_t pattern_signature;
+    std::array<char16_t, 64> folded{};
+    std::array<std::uint64_t, 256> latin1{};
+    std::vector<std::pair<char16_t, std::uint64_t>> other;
+};
+
+/// Ranks of the best `k` of `n` sorted candidates, best first, ties go to the lower rank
+/// \param score Score of the candidate of rank `i`, nullopt when it doesn't match
+template <std::invocable<size_t> ScoreAt>
+std::vector<size_t> bestMatches(size_t n, size_t k, ScoreAt&& score) {
+    if (k == 0) {
+        return {};
+    }
+    // Max-heap of the best `k` so far
+    std::vector<std::pair<FuzzyPattern::Score, size_t>> best;
+    best.reserve(k + 1);
+    for (size_t i = 0; i < n; ++i) {
+        auto const s = score(i);
+        if (!s || (best.size() == k && !(std::pair(*s, i) < best.front()))) {
+            continue;
+        }
+        best.emplace_back(*s, i);
+        std::ranges::push_heap(best);
+        if (best.size() > k) {
+            std::ranges::pop_heap(best);
+            best.pop_back();
+        }
+    }
+    std::ranges::sort_heap(best);
+    std::vector<size_t> ret;
+    ret.reserve(best.size());
+    for (auto const& [_, i] : best) {
+        ret.push_back(i);
+    }
+    return ret;
+}
+
+/// Vocabulary sorted ignoring case, so that the words starting with a prefix form a range found by binary search
+class CompletionIndex {
+public:
+    CompletionIndex() = default;
+
+    template <std::ranges::input_range Range>
+    explicit CompletionIndex(Range const& words) : words(std::ranges::begin(words), std::ranges::end(words)) {
+        std::ranges::sort(this->words, [](QString const& a, QString const& b) {
+            auto const c = QString::compare(a, b, Qt::CaseInsensitive);
+            return c != 0 ? c < 0 : a < b;
+        });
+        auto const [first, last] = std::ranges::unique(this->words);
+        this->words.erase(first, last);
+        signatures.reserve(this->words.size());
+        for (auto const& x : this->words) {
+            signatures.push_back(FuzzyPattern::signature(x));
+        }
+    }
+
+    bool empty() const {
+        return words.empty();
+    }
+
+    size_t size() const {
+        return words.size();
+    }
+
+    /// Words starting with `prefix`, ignoring case
+    std::span<QString const> matches(QStringView prefix) const {
+        auto const cmp = [prefix](QString const& x) {
+            return QStringView(x).left(prefix.size()).compare(prefix, Qt::CaseInsensitive);
+        };
+        auto const first = std::ranges::partition_point(words, [&](auto const& x) { return cmp(x) < 0; });
+        auto const last =
+            std::ranges::partition_point(first, words.end(), [&](auto const& x) { return cmp(x) == 0; });
+        return {first, last};
+    }
+
+    /// The first `k` words starting with `prefix`
+    QStringList complete(QStringView prefix, size_t k) const {
+        auto const range = matches(prefix);
+        auto const top = range.first(std::min(k, range.size()));
+        return QStringList(top.begin(), top.end());
+    }
+
+    /// The `k` best words matching `pattern` loosely, see `FuzzyPattern`
+    QStringList completeFuzzy(QStringView pattern, size_t k) const {
+        FuzzyPattern const fuzzy(pattern);
+        auto const best = bestMatches(words.size(), k, [&](size_t i) -> std::optional<FuzzyPattern::Score> {
+            if (!fuzzy.mayMatch(signatures[i])) {
+                return std::nullopt;
+            }
+            return fuzzy.score(words[i]);
+        });
+        QStringList ret;
+        ret.reserve(static_cast<qsizetype>(best.size()));
+        for (auto const i : best) {
+            ret.push_back(words[i]);
+        }
+        return ret;
+    }
+
+private:
+    std::vector<QString> words;
+    std::vector<std::uint64_t> signatures;
+};
+
+/// Queries a `CompletionProvider` on a worker thread once typing pauses.
+/// Every request stops the one before it, only the answer to the latest prefix is delivered.
+class AsyncCompletion {
+public:
+    using Done = std::function<void(QString const& prefix, QStringList const& completions)>;
+
+    /// \param context Object on whose thread `done` is called
+    AsyncCompletion(CompletionProvider provider, std::chrono::milliseconds delay, QObject* context, Done done)
+        : provider{std::move(provider)}, context{context}, done{std::move(done)} {
+        pool.setMaxThreadCount(1);
+        timer.setSingleShot(true);
+        timer.setInterval(delay);
+        QObject::connect(&timer, &QTimer::timeout, context, [this] { start(); });
+    }
+
+    AsyncCompletion(AsyncCompletion const&) = delete;
+    AsyncCompletion& operator=(AsyncCompletion const&) = delete;
+
+    ~AsyncCompletion() {
+        cancel();
+        pool.waitForDone();
+    }
+
+    /// Restarts the delay with `prefix`, stopping the lookup in flight
+    void request(QString prefix) {
+        cancel();
+        pending = std::move(prefix);
+        timer.start();
+    }
+
+    void cancel() {
+        timer.stop();
+        stop.request_stop();
+    }
+
+private:
+    struct Task : QRunnable {
+        explicit Task(std::function<void()> f) : f{std::move(f)} {}
+
+        void run() override {
+            f();
+        }
+
+        std::function<void()> f;
+    };
+
+    void start() {
+        stop = std::stop_source();
+        pool.start(new Task([provider = provider, prefix = pending, token = stop.get_token(), context = context,
+                             done = done] {
+            if (token.stop_requested()) {
+                return;
+            }
+            auto completions = provider(prefix, token);
+            if (token.stop_requested()) {
+                return;
+            }
+            QMetaObject::invokeMethod(
+                context,
+                [prefix, token, done, completions = std::move(completions)] {
+                    if (!token.stop_requested()) {
+                        done(prefix, completions);
+                    }
+                },
+                Qt::QueuedConnection);
+        }));
+    }
+
+    CompletionProvider provider;
+    QObject* context;
+    Done done;
+    QString pending;
+    QTimer timer;
+    QThreadPool pool;
+    std::stop_source stop;
+};
+
+} // namespace everload_tags
@@ -0,0 +1,281 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Nicolai Trandafil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "everload_tags/completion_dictionary.hpp"
+
+#include "completion.hpp"
+
+#include <QFile>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace everload_tags {
+
+namespace {
+
+constexpr std::array<char, 8> magic{'E', 'V', 'T', 'A', 'G', 'D', 'I', 'C'};
+constexpr std::uint32_t version = 1;
+constexpr size_t prefix_index_size = 256 * 256 + 1;
+
+struct Header {
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t count;
+    std::uint64_t offsets;
+    std::uint64_t text;
+    std::uint64_t text_size;
+    std::uint64_t prefix_index; ///< 0 when there is none
+};
+
+/// The mapping might not be aligned for `T`
+template <class T>
+T load(uchar const* p, size_t i) {
+    T ret;
+    std::memcpy(&ret, p + i * sizeof(T), sizeof(T));
+    return ret;
+}
+
+uchar foldAscii(char c) {
+    auto const u = static_cast<uchar>(c);
+    return u >= 'A' && u <= 'Z' ? static_cast<uchar>(u + ('a' - 'A')) : u;
+}
+
+/// Compares at most the first `n` bytes, ignoring ASCII case
+int compareFolded(std::string_view a, std::string_view b, size_t n = std::string_view::npos) {
+    a = a.substr(0, n);
+    b = b.substr(0, n);
+    for (size_t i = 0; i < std::min(a.size(), b.size()); ++i) {
+        auto const x = foldAscii(a[i]);
+        auto const y = foldAscii(b[i]);
+        if (x != y) {
+            return x < y ? -1 : 1;
+        }
+    }
+    return a.size() < b.size() ? -1 : a.size() > b.size() ? 1 : 0;
+}
+
+/// Slot of `word` in the prefix index
+size_t prefixKey(std::string_view word) {
+    return word.empty() ? 0 : foldAscii(word[0]) * 256 + (word.size() > 1 ? foldAscii(word[1]) : 0);
+}
+
+/// First rank in [first, last) for which `pred` is false
+template <std::predicate<size_t> Pred>
+size_t partitionPoint(size_t first, size_t last, Pred&& pred) {
+    while (first < last) {
+        auto const mid = first + (last - first) / 2;
+        if (pred(mid)) {
+            first = mid + 1;
+        } else {
+            last = mid;
+        }
+    }
+    return first;
+}
+
+/// UTF-8 to UTF-16 into a reused buffer, to score the words without allocating for each
+void decode(std::string_view utf8, std::u16string& out) {
+    out.clear();
+    for (size_t i = 0; i < utf8.size();) {
+        auto const c = static_cast<uchar>(utf8[i]);
+        size_t const n = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xe ? 3 : 4;
+        if (i + n > utf8.size()) {
+            break;
+        }
+        char32_t cp = n == 1 ? c : n == 2 ? c & 0x1f : n == 3 ? c & 0x0f : c & 0x07;
+        for (size_t j = 1; j < n; ++j) {
+            cp = (cp << 6) | (static_cast<uchar>(utf8[i + j]) & 0x3f);
+        }
+        i += n;
+        if (cp >= 0x10000) {
+            cp -= 0x10000;
+            out.push_back(static_cast<char16_t>(0xd800 + (cp >> 10)));
+            out.push_back(static_cast<char16_t>(0xdc00 + (cp & 0x3ff)));
+        } else {
+            out.push_back(static_cast<char16_t>(cp));
+        }
+    }
+}
+
+} // namespace
+
+bool CompletionDictionary::write(QString const& path, std::vector<QString> words, bool prefix_index) {
+    std::vector<std::string> texts;
+    texts.reserve(words.size());
+    for (auto const& x : words) {
+        auto const utf8 = x.toUtf8();
+        texts.emplace_back(utf8.constData(), static_cast<size_t>(utf8.size()));
+    }
+    words = {};
+    std::ranges::sort(texts, [](std::string const& a, std::string const& b) {
+        auto const c = compareFolded(a, b);
+        return c != 0 ? c < 0 : a < b;
+    });
+    auto const [first, last] = std::ranges::unique(texts);
+    texts.erase(first, last);
+
+    std::vector<std::uint32_t> offsets;
+    offsets.reserve(texts.size() + 1);
+    std::uint64_t text_size = 0;
+    for (auto const& x : texts) {
+        offsets.push_back(static_cast<std::uint32_t>(text_size));
+        text_size += x.size();
+    }
+    if (text_size > std::numeric_limits<std::uint32_t>::max()) {
+        return false;
+    }
+    offsets.push_back(static_cast<std::uint32_t>(text_size));
+
+    std::vector<std::uint32_t> index;
+    if (prefix_index) {
+        index.reserve(prefix_index_size);
+        size_t rank = 0;
+        for (size_t key = 0; key < prefix_index_size; ++key) {
+            while (rank < texts.size() && prefixKey(texts[rank]) < key) {
+                ++rank;
+            }
+            index.push_back(static_cast<std::uint32_t>(rank));
+        }
+    }
+
+    Header header{};
+    header.magic = magic;
+    header.version = version;
+    header.count = static_cast<std::uint32_t>(texts.size());
+    header.offsets = sizeof(Header);
+    header.text = header.offsets + offsets.size() * sizeof(std::uint32_t);
+    header.text_size = text_size;
+    header.prefix_index = prefix_index ? header.text + text_size : 0;
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    auto const put = [&](void const* p, size_t n) {
+        return file.write(static_cast<char const*>(p), static_cast<qint64>(n)) == static_cast<qint64>(n);
+    };
+    auto ok = put(&header, sizeof(header)) && put(offsets.data(), offsets.size() * sizeof(std::uint32_t));
+    for (auto const& x : texts) {
+        ok = ok && put(x.data(), x.size());
+    }
+    ok = ok && put(index.data(), index.size() * sizeof(std::uint32_t));
+    return ok && file.commit();
+}
+
+std::optional<CompletionDictionary> CompletionDictionary::open(QString const& path) {
+    auto file = std::make_shared<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly) || file->size() < static_cast<qint64>(sizeof(Header))) {
+        return std::nullopt;
+    }
+    auto const* data = file->map(0, file->size());
+    if (!data) {
+        return std::nullopt;
+    }
+
+    auto const size = static_cast<std::uint64_t>(file->size());
+    auto const within = [size](std::uint64_t offset, std::uint64_t n) { return offset <= size && n <= size - offset; };
+    auto const header = load<Header>(data, 0);
+    if (header.magic != magic || header.version != version ||
+        !within(header.offsets, (std::uint64_t{header.count} + 1) * sizeof(std::uint32_t)) ||
+        !within(header.text, header.text_size) ||
+        (header.prefix_index != 0 && !within(header.prefix_index, prefix_index_size * sizeof(std::uint32_t)))) {
+        return std::nullopt;
+    }
+
+    CompletionDictionary ret;
+    ret.file = std::move(file);
+    ret.count = header.count;
+    ret.offsets = data + header.offsets;
+    ret.text = reinterpret_cast<char const*>(data + header.text);
+    ret.text_size = header.text_size;
+    ret.prefix_index = header.prefix_index != 0 ? data + header.prefix_index : nullptr;
+    return ret;
+}
+
+std::string_view CompletionDictionary::bytes(size_t i) const {
+    // Clamped, a corrupt offset table must not read out of the mapping
+    auto const begin = std::min<size_t>(load<std::uint32_t>(offsets, i), text_size);
+    auto const end = std::clamp<size_t>(load<std::uint32_t>(offsets, i + 1), begin, text_size);
+    return {text + begin, end - begin};
+}
+
+QString CompletionDictionary::word(size_t i) const {
+    auto const x = bytes(i);
+    return QString::fromUtf8(x.data(), static_cast<qsizetype>(x.size()));
+}
+
+std::pair<size_t, size_t> CompletionDictionary::matches(QStringView prefix) const {
+    auto const utf8 = prefix.toUtf8();
+    std::string_view const key(utf8.constData(), static_cast<size_t>(utf8.size()));
+
+    size_t first = 0;
+    size_t last = count;
+    if (prefix_index && !key.empty()) {
+        auto const slot = prefixKey(key);
+        first = std::min<size_t>(load<std::uint32_t>(prefix_index, slot), count);
+        last = std::clamp<size_t>(load<std::uint32_t>(prefix_index, key.size() > 1 ? slot + 1 : slot + 256), first,
+                                  count);
+    }
+
+    auto const cmp = [&](size_t i) { return compareFolded(bytes(i), key, key.size()); };
+    first = partitionPoint(first, last, [&](size_t i) { return cmp(i) < 0; });
+    last = partitionPoint(first, last, [&](size_t i) { return cmp(i) == 0; });
+    return {first, last};
+}
+
+QStringList CompletionDictionary::complete(QStringView prefix, size_t k) const {
+    auto const [first, last] = matches(prefix);
+    QStringList ret;
+    for (auto i = first; i < std::min(last, first + k); ++i) {
+        ret.push_back(word(i));
+    }
+    return ret;
+}
+
+QStringList CompletionDictionary::completeFuzzy(QStringView pattern, size_t k) const {
+    FuzzyPattern const fuzzy(pattern);
+    std::u16string buffer;
+    auto const best = bestMatches(count, k, [&](size_t i) -> std::optional<FuzzyPattern::Score> {
+        decode(bytes(i), buffer);
+        QStringView const word(buffer.data(), static_cast<qsizetype>(buffer.size()));
+        if (!fuzzy.mayMatch(FuzzyPattern::signature(word))) {
+            return std::nullopt;
+        }
+        return fuzzy.score(word);
+    });
+    QStringList ret;
+    ret.reserve(static_cast<qsizetype>(best.size()));
+    for (auto const i : best) {
+        ret.push_back(word(i));
+    }
+    return ret;
+}
+
+} // namespace everload_tags
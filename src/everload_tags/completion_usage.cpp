@@ -0,0 +1,147 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Nicolai Trandafil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "everload_tags/completion_usage.hpp"
+
+#include <QDataStream>
+
+#include <algorithm>
+#include <limits>
+
+namespace everload_tags {
+
+namespace {
+
+constexpr quint32 magic = 0x45545553; // "ETUS"
+constexpr quint32 version = 1;
+
+} // namespace
+
+CompletionUsage::CompletionUsage(size_t max_size) : max_size{max_size} {
+    entries.reserve(max_size);
+}
+
+void CompletionUsage::record(QString const& text) {
+    if (text.isEmpty() || max_size == 0) {
+        return;
+    }
+    if (auto const it = positions.find(text); it != positions.end()) {
+        auto& count = entries[it->second].count;
+        count += count < std::numeric_limits<std::uint32_t>::max();
+        return;
+    }
+    if (entries.size() < max_size) {
+        insert(text, 1);
+        return;
+    }
+    auto const min = std::ranges::min_element(entries, {}, &Entry::count);
+    positions.erase(min->text);
+    positions.emplace(text, static_cast<size_t>(min - entries.begin()));
+    min->text = text;
+    min->count += min->count < std::numeric_limits<std::uint32_t>::max();
+}
+
+std::uint32_t CompletionUsage::count(QString const& text) const {
+    auto const it = positions.find(text);
+    return it != positions.end() ? entries[it->second].count : 0;
+}
+
+QStringList CompletionUsage::top(QStringView prefix, size_t k) const {
+    std::vector<Entry const*> matches;
+    for (auto const& x : entries) {
+        if (QStringView(x.text).startsWith(prefix, Qt::CaseInsensitive)) {
+            matches.push_back(&x);
+        }
+    }
+    auto const n = std::min(k, matches.size());
+    std::ranges::partial_sort(matches, matches.begin() + static_cast<std::ptrdiff_t>(n),
+                              [](Entry const* a, Entry const* b) {
+                                  return a->count != b->count ? a->count > b->count : a->text < b->text;
+                              });
+    QStringList ret;
+    ret.reserve(static_cast<qsizetype>(n));
+    for (size_t i = 0; i < n; ++i) {
+        ret.push_back(matches[i]->text);
+    }
+    return ret;
+}
+
+void CompletionUsage::rank(QStringList& words) const {
+    std::stable_sort(words.begin(), words.end(),
+                     [this](QString const& a, QString const& b) { return count(a) > count(b); });
+}
+
+QByteArray CompletionUsage::save() const {
+    QByteArray ret;
+    QDataStream out(&ret, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << magic << version << static_cast<quint32>(entries.size());
+    for (auto const& x : entries) {
+        out << x.text << static_cast<quint32>(x.count);
+    }
+    return ret;
+}
+
+bool CompletionUsage::restore(QByteArray const& blob) {
+    QDataStream in(blob);
+    in.setVersion(QDataStream::Qt_5_12);
+    quint32 blob_magic = 0;
+    quint32 blob_version = 0;
+    quint32 size = 0;
+    in >> blob_magic >> blob_version >> size;
+    if (in.status() != QDataStream::Ok || blob_magic != magic || blob_version != version) {
+        return false;
+    }
+
+    std::vector<Entry> restored;
+    for (quint32 i = 0; i < size && in.status() == QDataStream::Ok; ++i) {
+        Entry x;
+        quint32 count = 0;
+        in >> x.text >> count;
+        x.count = count;
+        restored.push_back(std::move(x));
+    }
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    // A blob from a larger instance keeps its most used
+    std::ranges::stable_sort(restored, std::ranges::greater{}, &Entry::count);
+    entries.clear();
+    positions.clear();
+    for (auto const& x : restored) {
+        if (entries.size() < max_size && !x.text.isEmpty() && !positions.contains(x.text)) {
+            insert(x.text, x.count);
+        }
+    }
+    return true;
+}
+
+void CompletionUsage::insert(QString const& text, std::uint32_t count) {
+    positions.emplace(text, entries.size());
+    entries.push_back(Entry{text, count});
+}
+
+} // namespace everload_tags
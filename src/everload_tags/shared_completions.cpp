@@ -0,0 +1,82 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Nicolai Trandafil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "everload_tags/shared_completions.hpp"
+
+#include "completion.hpp"
+
+#include <variant>
+
+namespace everload_tags {
+
+struct SharedCompletions::Snapshot {
+    std::variant<CompletionIndex, CompletionDictionary> vocabulary;
+};
+
+SharedCompletions::SharedCompletions() : current{std::make_shared<Snapshot const>()} {}
+
+SharedCompletions::SharedCompletions(std::vector<QString> const& words)
+    : current{std::make_shared<Snapshot const>(Snapshot{CompletionIndex(words)})} {}
+
+SharedCompletions::SharedCompletions(CompletionDictionary dictionary)
+    : current{std::make_shared<Snapshot const>(Snapshot{std::move(dictionary)})} {}
+
+SharedCompletions::~SharedCompletions() = default;
+
+void SharedCompletions::set(std::vector<QString> const& words) {
+    // Sorting happens before taking the lock
+    swap(std::make_shared<Snapshot const>(Snapshot{CompletionIndex(words)}));
+}
+
+void SharedCompletions::set(CompletionDictionary dictionary) {
+    swap(std::make_shared<Snapshot const>(Snapshot{std::move(dictionary)}));
+}
+
+size_t SharedCompletions::size() const {
+    return std::visit([](auto const& x) { return x.size(); }, snapshot()->vocabulary);
+}
+
+QStringList SharedCompletions::complete(QStringView prefix, size_t k) const {
+    return std::visit([&](auto const& x) { return x.complete(prefix, k); }, snapshot()->vocabulary);
+}
+
+QStringList SharedCompletions::completeFuzzy(QStringView pattern, size_t k) const {
+    return std::visit([&](auto const& x) { return x.completeFuzzy(pattern, k); }, snapshot()->vocabulary);
+}
+
+std::shared_ptr<SharedCompletions::Snapshot const> SharedCompletions::snapshot() const {
+    std::lock_guard const lock(mutex);
+    return current;
+}
+
+void SharedCompletions::swap(std::shared_ptr<Snapshot const> next) {
+    {
+        std::lock_guard const lock(mutex);
+        current.swap(next);
+    }
+    // The old snapshot is released here, out of the lock
+}
+
+} // namespace everload_tags
@@ -0,0 +1,58 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Nicolai Trandafil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "string_pool.hpp"
+
+namespace everload_tags {
+
+StringPool& StringPool::global() {
+    static StringPool pool;
+    return pool;
+}
+
+QString StringPool::intern(QString const& text) {
+    if (text.isEmpty()) {
+        return text;
+    }
+    std::lock_guard lock(mutex);
+    auto const it = texts.try_emplace(text, 0).first;
+    ++it->second;
+    return it->first;
+}
+
+void StringPool::release(QString const& text) {
+    std::lock_guard lock(mutex);
+    auto const it = texts.find(text);
+    if (it != texts.end() && --it->second == 0) {
+        texts.erase(it);
+    }
+}
+
+size_t StringPool::size() const {
+    std::lock_guard lock(mutex);
+    return texts.size();
+}
+
+} // namespace everload_tags
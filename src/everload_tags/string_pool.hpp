@@ -0,0 +1,54 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Nicolai Trandafil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <QString>
+
+#include <mutex>
+#include <unordered_map>
+
+namespace everload_tags {
+
+/// Pool of texts shared process-wide, so that equal tags of all the widgets share one implicitly shared buffer.
+/// A text leaves the pool with the last reference taken on it. Thread-safe.
+class StringPool {
+public:
+    static StringPool& global();
+
+    /// The pooled copy of `text`, equal to it, taking a reference on it. Empty texts are not pooled.
+    QString intern(QString const& text);
+
+    /// Drop a reference taken by `intern`
+    void release(QString const& text);
+
+    size_t size() const;
+
+private:
+    mutable std::mutex mutex;
+    std::unordered_map<QString, size_t> texts; ///< With their references
+};
+
+} // namespace everload_tags
@@ -37,8 +37,11 @@
 #include <QStyleHints>
 #include <QStyleOptionFrame>
 #include <QTextLayout>
+#include <QTimer>
 
+#include <algorithm>
 #include <cassert>
+#include <limits>
 
 namespace everload_tags {
 
@@ -52,7 +55,7 @@ struct TagsEdit::Impl : Common {
     using Common::drawTags;
 
     template <std::ranges::input_range Range>
-    void drawTags(QPainter& p, Range range) const {
+    void drawTags(QPainter& p, Range range) {
         drawTags(p, range, ifce->fontMetrics(), -offset(),
                  !read_only && (!restore_cursor_position_on_focus_click || ifce->hasFocus()));
     }
@@ -61,38 +64,62 @@ struct TagsEdit::Impl : Common {
         editorText() = text;
         moveCursor(editorText().length(), false);
         update1();
+        emitChanges(ifce);
     }
 
     void setupCompleter() {
         completer->setWidget(ifce);
+        setupCompleterModel();
         QObject::connect(completer.get(), qOverload<QString const&>(&QCompleter::activated),
                          [this](QString const& text) { setEditorText(text); });
     }
 
-    using Common::calcRects;
-
-    void calcRects(QRect r, QPoint& lt, QFontMetrics const& fm) {
-        auto const middle = tags.begin() + static_cast<ptrdiff_t>(editing_index);
-
-        calcRects(lt, std::ranges::subrange(tags.begin(), middle), fm, r, !read_only);
-
-        if (cursorVisible() || !editorText().isEmpty()) {
-            calcRects(lt, std::ranges::subrange(middle, middle + 1), fm, r, !read_only);
+    /// \param bottom See `relayout`, the height of the tags left is estimated
+    QRect calcRects(QRect r, int bottom = std::numeric_limits<int>::max()) {
+        auto const fm = ifce->fontMetrics();
+        auto const lt = relayout(r.topLeft(), fm, r, !read_only, bottom);
+        auto const height = pillHeight(fm.height());
+        r.setBottom(laidOutEnd() == tags.size() ? lt.y() + height - 1 : estimatedBottom(r.topLeft(), height));
+        if (laidOutEnd() != tags.size() && !layout_timer.isActive()) {
+            layout_timer.start();
         }
+        return r;
+    }
 
-        calcRects(lt, std::ranges::subrange(middle + 1, tags.end()), fm, r, !read_only);
+    QRect calcRects() {
+        auto const r = contentsRect();
+        return calcRects(r, lazy_layout ? visibleBottom() : std::numeric_limits<int>::max());
     }
 
-    QRect calcRects(QRect r) {
-        auto lt = r.topLeft();
-        auto const fm = ifce->fontMetrics();
-        calcRects(r, lt, fm);
-        r.setBottom(lt.y() + pillHeight(fm.height()) - 1);
-        return r;
+    /// Bottom of the viewport and a page below it
+    int visibleBottom() const {
+        auto const r = contentsRect();
+        return r.bottom() + ifce->verticalScrollBar()->value() + r.height();
     }
 
-    QRect calcRects() {
-        return calcRects(contentsRect());
+    /// Lays out the tags left by the lazy layout a chunk at a time, while the event loop is idle
+    void setupLazyLayout() {
+        layout_timer.setSingleShot(true);
+        layout_timer.setInterval(0);
+        QObject::connect(&layout_timer, &QTimer::timeout, ifce, [this] {
+            if (laidOutEnd() == tags.size()) {
+                return;
+            }
+            auto const chunk = 256 * (pillHeight(ifce->fontMetrics().height()) + tag_v_spacing);
+            calcRects(contentsRect(), tags[laidOutEnd() - (laidOutEnd() != 0)].rect.bottom() + chunk);
+            updateVScrollRange();
+            updateHScrollRange();
+            if (scroll_to_editor && editorPlaced()) {
+                ensureCursorIsVisibleV();
+                ensureCursorIsVisibleH();
+                ifce->viewport()->update();
+            }
+        });
+        QObject::connect(ifce->verticalScrollBar(), &QScrollBar::valueChanged, ifce, [this] {
+            if (lazy_layout && laidOutEnd() != tags.size()) {
+                calcRectsUpdateScrollRanges();
+            }
+        });
     }
 
     QRect contentsRect() const {
@@ -116,17 +143,19 @@ struct TagsEdit::Impl : Common {
         ifce->verticalScrollBar()->setPageStep(row_h);
         assert(!tags.empty()); // Invariant-1
 
+        auto const contents_rect = contentsRect();
         int top = tags.front().rect.top();
-        int bottom = tags.back().rect.bottom();
+        int bottom = laidOutEnd() == tags.size() ? tags.back().rect.bottom()
+                                                 : estimatedBottom(contents_rect.topLeft(), pillHeight(fm.height()));
 
         if (editing_index == 0 && !(cursorVisible() || !editorText().isEmpty())) {
             top = tags[1].rect.top();
-        } else if (editing_index == tags.size() - 1 && !(cursorVisible() || !editorText().isEmpty())) {
+        } else if (editing_index == tags.size() - 1 && laidOutEnd() == tags.size() &&
+                   !(cursorVisible() || !editorText().isEmpty())) {
             bottom = tags[tags.size() - 2].rect.bottom();
         }
 
         auto const h = bottom - top + 1;
-        auto const contents_rect = contentsRect();
 
         if (contents_rect.height() < h) {
             ifce->verticalScrollBar()->setRange(0, h - contents_rect.height());
@@ -137,7 +166,8 @@ struct TagsEdit::Impl : Common {
 
     void updateHScrollRange() {
         assert(!tags.empty()); // Invariant-1
-        auto const width = std::max_element(begin(tags), end(tags), [](auto const& x, auto const& y) {
+        auto const laid_end = begin(tags) + static_cast<ptrdiff_t>(std::max<size_t>(laidOutEnd(), 1));
+        auto const width = std::max_element(begin(tags), laid_end, [](auto const& x, auto const& y) {
                                return x.rect.width() < y.rect.width();
                            })->rect.width();
 
@@ -154,6 +184,11 @@ struct TagsEdit::Impl : Common {
         if (!cursorVisible()) {
             return;
         }
+        if (!editorPlaced()) { // once the lazy layout gets there
+            scroll_to_editor = true;
+            return;
+        }
+        scroll_to_editor = false;
         auto const fm = ifce->fontMetrics();
         auto const row_h = pillHeight(fm.height());
         auto const vscroll = ifce->verticalScrollBar()->value();
@@ -168,7 +203,7 @@ struct TagsEdit::Impl : Common {
     }
 
     void ensureCursorIsVisibleH() {
-        if (!cursorVisible()) {
+        if (!cursorVisible() || !editorPlaced()) { // see `ensureCursorIsVisibleV`
             return;
         }
         auto const contents_rect = contentsRect().translated(ifce->horizontalScrollBar()->value(), 0);
@@ -181,17 +216,38 @@ struct TagsEdit::Impl : Common {
     }
 
     void update1(bool keep_cursor_visible = true) {
+        scroll_to_editor = false;
+        markDirty(editing_index);
+        updateCursorBlinking(ifce); // before the layout, the editor might appear or disappear
         updateDisplayText();
         calcRectsUpdateScrollRanges();
         if (keep_cursor_visible) {
             ensureCursorIsVisibleV();
             ensureCursorIsVisibleH();
         }
-        updateCursorBlinking(ifce);
         ifce->viewport()->update();
     }
 
     TagsEdit* const ifce;
+    QTimer layout_timer;
+
+    /// Set when the cursor is to be scrolled to once the lazy layout places the editor
+    bool scroll_to_editor{false};
+
+    /// Widths the layouts query are few, the oldest is forgotten first
+    static constexpr size_t max_memoized_heights = 8;
+
+    struct MemoizedHeight {
+        int width;
+        int bottom; ///< The lazy layout extrapolates from there, it moves with the scroll position
+        int height;
+    };
+
+    /// Results of `heightForWidth` by contents width and bottom, for `content_generation`
+    struct {
+        size_t generation{npos};
+        std::vector<MemoizedHeight> heights;
+    } heights;
 };
 
 TagsEdit::TagsEdit(QWidget* parent, Config config)
@@ -207,6 +263,7 @@ TagsEdit::TagsEdit(QWidget* parent, Config config)
     setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
 
     impl->setupCompleter();
+    impl->setupLazyLayout();
     impl->setCursorVisible(hasFocus(), this);
     impl->updateDisplayText();
 
@@ -248,25 +305,30 @@ void TagsEdit::paintEvent(QPaintEvent* e) {
 
     p.setClipRect(impl->contentsRect());
 
-    auto const middle = impl->tags.cbegin() + static_cast<ptrdiff_t>(impl->editing_index);
+    // only the exposed tags
+    auto const [first, last] = impl->tagsSpanning(e->rect().translated(impl->offset()));
+    auto const at = [this](size_t i) { return impl->tags.cbegin() + static_cast<ptrdiff_t>(i); };
+    auto const middle = std::clamp(impl->editing_index, first, last);
 
     // tags
-    impl->drawTags(p, std::ranges::subrange(impl->tags.cbegin(), middle));
+    impl->drawTags(p, std::ranges::subrange(at(first), at(middle)));
 
-    if (impl->cursorVisible()) {
-        impl->drawEditor(p, palette(), impl->offset());
-    } else if (!impl->editorText().isEmpty()) {
-        impl->drawTags(p, std::ranges::subrange(middle, middle + 1));
+    if (middle != last && middle == impl->editing_index) {
+        if (impl->cursorVisible()) {
+            impl->drawEditor(p, palette(), impl->offset());
+        } else if (!impl->editorText().isEmpty()) {
+            impl->drawTags(p, std::ranges::subrange(at(middle), at(middle + 1)));
+        }
     }
 
     // tags
-    impl->drawTags(p, std::ranges::subrange(middle + 1, impl->tags.cend()));
+    impl->drawTags(p, std::ranges::subrange(at(std::clamp(impl->editing_index + 1, first, last)), at(last)));
 }
 
 void TagsEdit::timerEvent(QTimerEvent* event) {
     if (event->timerId() == impl->blink_timer) {
         impl->blink_status = !impl->blink_status;
-        viewport()->update();
+        viewport()->update(impl->cursorRect().translated(-impl->offset()));
     }
 }
 
@@ -280,50 +342,31 @@ void TagsEdit::mousePressEvent(QMouseEvent* event) {
     bool keep_cursor_visible = true;
     EVERLOAD_TAGS_SCOPE_EXIT {
         impl->update1(keep_cursor_visible);
+        impl->emitChanges(this);
     };
 
-    // remove or edit a tag
-    for (size_t i = 0; i < impl->tags.size(); ++i) {
-        if (!impl->tags[i].rect.translated(-impl->offset()).contains(event->pos())) {
-            continue;
-        }
+    auto const pos = event->pos() + impl->offset();
 
-        if (impl->inCrossArea(i, event->pos(), impl->offset())) {
-            impl->removeTag(i);
+    // remove or edit a tag
+    if (auto const i = impl->tagAt(pos)) {
+        if (impl->inCrossArea(*i, event->pos(), impl->offset())) {
+            impl->removeTag(*i);
             keep_cursor_visible = false;
-        } else if (impl->editing_index == i) {
+        } else if (impl->editing_index == *i) {
             impl->moveCursor(
                 impl->text_layout.lineAt(0).xToCursor(
                     (event->pos() - (impl->editorRect() - impl->pill_thickness).translated(-impl->offset()).topLeft())
                         .x()),
                 false);
         } else {
-            impl->editTag(i);
+            impl->editTag(*i);
         }
 
         return;
     }
 
-    // add new tag closest to the cursor
-    for (auto it = begin(impl->tags); it != end(impl->tags); ++it) {
-        // find the row
-        if (it->rect.translated(-impl->offset()).bottom() < event->pos().y()) {
-            continue;
-        }
-
-        // find the closest spot
-        auto const row = it->rect.translated(-impl->offset()).top();
-        while (it != end(impl->tags) && it->rect.translated(-impl->offset()).top() == row &&
-               event->pos().x() > it->rect.translated(-impl->offset()).left()) {
-            ++it;
-        }
-
-        impl->editNewTag(static_cast<size_t>(std::distance(begin(impl->tags), it)));
-        return;
-    }
-
-    // append a new nag
-    impl->editNewTag(impl->tags.size());
+    // add new tag closest to the cursor, or append it
+    impl->editNewTag(impl->insertionIndex(pos));
 }
 
 QSize TagsEdit::sizeHint() const {
@@ -342,10 +385,26 @@ int TagsEdit::heightForWidth(int w) const {
     auto const content_width = w;
     QRect contents_rect(0, 0, content_width, 100);
     contents_rect -= contentsMargins() + viewport()->contentsMargins() + viewportMargins();
-    auto tags = impl->tags;
-    contents_rect = impl->calcRects(contents_rect);
+    auto& memo = impl->heights;
+    if (memo.generation != impl->content_generation) {
+        memo.generation = impl->content_generation;
+        memo.heights.clear();
+    }
+    auto const width = contents_rect.width();
+    auto const bottom = impl->lazy_layout ? impl->visibleBottom() : std::numeric_limits<int>::max();
+    auto const it =
+        std::ranges::find_if(memo.heights, [&](auto const& x) { return x.width == width && x.bottom == bottom; });
+    if (it != memo.heights.end()) {
+        return it->height;
+    }
+    contents_rect.setBottom(impl->bottomFor(contents_rect, fontMetrics(), !impl->read_only, bottom));
     contents_rect += contentsMargins() + viewport()->contentsMargins() + viewportMargins();
-    return contents_rect.height();
+    auto const height = contents_rect.height();
+    if (memo.heights.size() == Impl::max_memoized_heights) {
+        memo.heights.erase(memo.heights.begin());
+    }
+    memo.heights.push_back({width, bottom, height});
+    return height;
 }
 
 void TagsEdit::keyPressEvent(QKeyEvent* event) {
@@ -398,7 +457,7 @@ void TagsEdit::keyPressEvent(QKeyEvent* event) {
             break;
         case Qt::Key_Space:
             if (!impl->editorText().isEmpty()) {
-                impl->editNewTag(impl->editing_index + 1);
+                impl->commitEditorText();
             }
             break;
         default:
@@ -418,36 +477,89 @@ void TagsEdit::keyPressEvent(QKeyEvent* event) {
 
     impl->update1();
 
-    impl->completer->setCompletionPrefix(impl->editorText());
-    impl->completer->complete();
+    impl->complete();
 
+    impl->emitChanges(this);
     emit tagsEdited();
 }
 
 void TagsEdit::completion(std::vector<QString> const& completions) {
-    impl->completer = std::make_unique<QCompleter>([&] {
-        QStringList ret;
-        std::copy(completions.begin(), completions.end(), std::back_inserter(ret));
-        return ret;
-    }());
-    impl->setupCompleter();
+    impl->setCompletions(std::make_shared<SharedCompletions>(completions));
 }
 
 void TagsEdit::completion(QStringList const& completions) {
-    impl->completer = std::make_unique<QCompleter>(completions);
-    impl->setupCompleter();
+    impl->setCompletions(
+        std::make_shared<SharedCompletions>(std::vector<QString>(completions.begin(), completions.end())));
+}
+
+void TagsEdit::completion(CompletionDictionary dictionary) {
+    impl->setCompletions(std::make_shared<SharedCompletions>(std::move(dictionary)));
+}
+
+void TagsEdit::completion(std::shared_ptr<SharedCompletions const> completions) {
+    impl->setCompletions(std::move(completions));
+}
+
+void TagsEdit::completionUsage(std::shared_ptr<CompletionUsage> usage) {
+    impl->usage = usage ? std::move(usage) : std::make_shared<CompletionUsage>();
+}
+
+std::shared_ptr<CompletionUsage> TagsEdit::completionUsage() const {
+    return impl->usage;
+}
+
+void TagsEdit::completionProvider(CompletionProvider provider, std::chrono::milliseconds delay) {
+    impl->setCompletionProvider(std::move(provider), delay);
 }
 
 void TagsEdit::tags(std::vector<QString> const& tags) {
     impl->setTags(tags);
+    impl->measureTexts(font(), fontMetrics());
     impl->update1();
 }
 
 void TagsEdit::tags(QStringList const& tags) {
     impl->setTags(tags);
+    impl->measureTexts(font(), fontMetrics());
     impl->update1();
 }
 
+void TagsEdit::replaceTags(size_t pos, size_t count, std::vector<QString> const& tags) {
+    impl->replaceTags(pos, count, tags);
+    impl->measureTexts(font(), fontMetrics());
+    impl->update1(false);
+    impl->emitChanges(this);
+    emit tagsEdited();
+}
+
+void TagsEdit::replaceTags(size_t pos, size_t count, QStringList const& tags) {
+    impl->replaceTags(pos, count, tags);
+    impl->measureTexts(font(), fontMetrics());
+    impl->update1(false);
+    impl->emitChanges(this);
+    emit tagsEdited();
+}
+
+void TagsEdit::insertTags(size_t pos, std::vector<QString> const& tags) {
+    replaceTags(pos, 0, tags);
+}
+
+void TagsEdit::insertTags(size_t pos, QStringList const& tags) {
+    replaceTags(pos, 0, tags);
+}
+
+void TagsEdit::appendTags(std::vector<QString> const& tags) {
+    replaceTags(std::numeric_limits<size_t>::max(), 0, tags);
+}
+
+void TagsEdit::appendTags(QStringList const& tags) {
+    replaceTags(std::numeric_limits<size_t>::max(), 0, tags);
+}
+
+void TagsEdit::removeTags(size_t pos, size_t count) {
+    replaceTags(pos, count, std::vector<QString>{});
+}
+
 std::vector<QString> TagsEdit::tags() const {
     std::vector<QString> ret;
     impl->getTags(ret);
@@ -460,12 +572,28 @@ QStringList TagsEdit::tags2() const {
     return ret;
 }
 
+TagsView TagsEdit::tagsView() const {
+    return TagsView(*impl, this);
+}
+
+void TagsEdit::model(QAbstractItemModel* model, int column) {
+    impl->bindModel(this, model, column, [this] {
+        impl->update1(false);
+        impl->emitChanges(this);
+        emit tagsEdited();
+    });
+    impl->update1();
+}
+
+QAbstractItemModel* TagsEdit::model() const {
+    return impl->model;
+}
+
 void TagsEdit::mouseMoveEvent(QMouseEvent* event) {
-    for (size_t i = 0; i < impl->tags.size(); ++i) {
-        if (impl->inCrossArea(i, event->pos(), impl->offset())) {
-            viewport()->setCursor(Qt::ArrowCursor);
-            return;
-        }
+    if (auto const i = impl->tagAt(event->pos() + impl->offset());
+        i && impl->inCrossArea(*i, event->pos(), impl->offset())) {
+        viewport()->setCursor(Qt::ArrowCursor);
+        return;
     }
     if (impl->contentsRect().contains(event->pos())) {
         viewport()->setCursor(Qt::IBeamCursor);
@@ -479,7 +607,10 @@ void TagsEdit::config(Config config) {
         impl->removeDuplicates();
     }
     static_cast<StyleConfig&>(*impl) = config.style;
+    impl->internTags(config.behavior.intern_tags);
     static_cast<BehaviorConfig&>(*impl) = config.behavior;
+    impl->forgetChanges();
+    impl->invalidateMeasurements();
     impl->update1();
 }
 
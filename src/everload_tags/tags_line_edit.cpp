@@ -39,6 +39,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <limits>
 
 namespace everload_tags {
 
@@ -55,7 +56,7 @@ struct TagsLineEdit::Impl : Common {
     using Common::drawTags;
 
     template <std::ranges::input_range Range>
-    void drawTags(QPainter& p, Range range) const {
+    void drawTags(QPainter& p, Range range) {
         drawTags(p, range, ifce->fontMetrics(), -offset(),
                  !read_only && (!restore_cursor_position_on_focus_click || ifce->hasFocus()));
     }
@@ -64,31 +65,20 @@ struct TagsLineEdit::Impl : Common {
         return ifce->contentsRect() - magic_margins;
     }
 
-    using Common::calcRects;
-
     void calcRects() {
-        auto const r = contentsRect();
-        auto lt = r.topLeft();
-
-        auto const middle = tags.begin() + static_cast<ptrdiff_t>(editing_index);
-
-        calcRects(lt, std::ranges::subrange(tags.begin(), middle), ifce->fontMetrics(), std::nullopt, !read_only);
-
-        if (cursorVisible() || !editorText().isEmpty()) {
-            calcRects(lt, std::ranges::subrange(middle, middle + 1), ifce->fontMetrics(), std::nullopt, !read_only);
-        }
-
-        calcRects(lt, std::ranges::subrange(middle + 1, tags.end()), ifce->fontMetrics(), std::nullopt, !read_only);
+        relayout(contentsRect().topLeft(), ifce->fontMetrics(), std::nullopt, !read_only);
     }
 
     void setEditorText(QString const& text) {
         tags[editing_index].text = text;
         moveCursor(editorText().length(), false);
         update1();
+        emitChanges(ifce);
     }
 
     void setupCompleter() {
         completer->setWidget(ifce);
+        setupCompleterModel();
         connect(completer.get(), static_cast<void (QCompleter::*)(QString const&)>(&QCompleter::activated), ifce,
                 [this](QString const& text) { setEditorText(text); });
     }
@@ -137,13 +127,14 @@ struct TagsLineEdit::Impl : Common {
     }
 
     void update1(bool keep_cursor_visible = true) {
+        markDirty(editing_index);
+        updateCursorBlinking(ifce); // before the layout, the editor might appear or disappear
         updateDisplayText();
         calcRects();
         updateHScrollRange();
         if (keep_cursor_visible) {
             ensureCursorIsVisible();
         }
-        updateCursorBlinking(ifce);
         ifce->update();
     }
 
@@ -228,25 +219,30 @@ void TagsLineEdit::paintEvent(QPaintEvent* e) {
     auto const rect = impl->contentsRect();
     p.setClipRect(rect);
 
-    auto const middle = impl->tags.cbegin() + static_cast<ptrdiff_t>(impl->editing_index);
+    // only the exposed tags
+    auto const [first, last] = impl->tagsSpanning(e->rect().translated(impl->offset()));
+    auto const at = [this](size_t i) { return impl->tags.cbegin() + static_cast<ptrdiff_t>(i); };
+    auto const middle = std::clamp(impl->editing_index, first, last);
 
     // tags
-    impl->drawTags(p, std::ranges::subrange(impl->tags.cbegin(), middle));
+    impl->drawTags(p, std::ranges::subrange(at(first), at(middle)));
 
-    if (impl->cursorVisible()) {
-        impl->drawEditor(p, palette(), impl->offset());
-    } else if (!impl->editorText().isEmpty()) {
-        impl->drawTags(p, std::ranges::subrange(middle, middle + 1));
+    if (middle != last && middle == impl->editing_index) {
+        if (impl->cursorVisible()) {
+            impl->drawEditor(p, palette(), impl->offset());
+        } else if (!impl->editorText().isEmpty()) {
+            impl->drawTags(p, std::ranges::subrange(at(middle), at(middle + 1)));
+        }
     }
 
     // tags
-    impl->drawTags(p, std::ranges::subrange(middle + 1, impl->tags.cend()));
+    impl->drawTags(p, std::ranges::subrange(at(std::clamp(impl->editing_index + 1, first, last)), at(last)));
 }
 
 void TagsLineEdit::timerEvent(QTimerEvent* event) {
     if (event->timerId() == impl->blink_timer) {
         impl->blink_status = !impl->blink_status;
-        update();
+        update(impl->cursorRect().translated(-impl->offset()));
     }
 }
 
@@ -260,43 +256,32 @@ void TagsLineEdit::mousePressEvent(QMouseEvent* event) {
     bool keep_cursor_visible = true;
     EVERLOAD_TAGS_SCOPE_EXIT {
         impl->update1(keep_cursor_visible);
+        impl->emitChanges(this);
     };
 
-    // remove or edit a tag
-    for (size_t i = 0; i < impl->tags.size(); ++i) {
-        if (!impl->tags[i].rect.translated(-impl->offset()).contains(event->pos())) {
-            continue;
-        }
+    auto const pos = event->pos() + impl->offset();
 
-        if (impl->inCrossArea(i, event->pos(), impl->offset())) {
-            impl->removeTag(i);
+    // remove or edit a tag
+    if (auto const i = impl->tagAt(pos)) {
+        if (impl->inCrossArea(*i, event->pos(), impl->offset())) {
+            impl->removeTag(*i);
             keep_cursor_visible = false;
-        } else if (impl->editing_index == i) {
+        } else if (impl->editing_index == *i) {
             impl->moveCursor(
                 impl->text_layout.lineAt(0).xToCursor(
                     (event->pos() - (impl->editorRect() - impl->pill_thickness).translated(-impl->offset()).topLeft())
                         .x()),
                 false);
         } else {
-            impl->editTag(i);
-        }
-
-        return;
-    }
-
-    // add new tag closed to the cursor
-    for (auto it = begin(impl->tags); it != end(impl->tags); ++it) {
-        // find the closest spot
-        if (event->pos().x() > it->rect.translated(-impl->offset()).left()) {
-            continue;
+            impl->editTag(*i);
         }
 
-        impl->editNewTag(static_cast<size_t>(std::distance(begin(impl->tags), it)));
         return;
     }
 
-    // append a new nag
-    impl->editNewTag(impl->tags.size());
+    // add new tag closed to the cursor, or append it
+    auto const it = std::ranges::partition_point(impl->tags, [&](auto const& x) { return x.rect.left() < pos.x(); });
+    impl->editNewTag(static_cast<size_t>(std::distance(begin(impl->tags), it)));
 }
 
 QSize TagsLineEdit::sizeHint() const {
@@ -376,7 +361,7 @@ void TagsLineEdit::keyPressEvent(QKeyEvent* event) {
             break;
         case Qt::Key_Space:
             if (!impl->editorText().isEmpty()) {
-                impl->editNewTag(impl->editing_index + 1);
+                impl->commitEditorText();
             }
             break;
         default:
@@ -396,34 +381,89 @@ void TagsLineEdit::keyPressEvent(QKeyEvent* event) {
 
     impl->update1();
 
-    impl->completer->setCompletionPrefix(impl->editorText());
-    impl->completer->complete();
+    impl->complete();
 
+    impl->emitChanges(this);
     emit tagsEdited();
 }
 
 void TagsLineEdit::completion(std::vector<QString> const& completions) {
-    QStringList tmp;
-    std::copy(begin(completions), end(completions), std::back_inserter(tmp));
-    impl->completer = std::make_unique<QCompleter>(std::move(tmp));
-    impl->setupCompleter();
+    impl->setCompletions(std::make_shared<SharedCompletions>(completions));
 }
 
 void TagsLineEdit::completion(QStringList const& completions) {
-    impl->completer = std::make_unique<QCompleter>(completions);
-    impl->setupCompleter();
+    impl->setCompletions(
+        std::make_shared<SharedCompletions>(std::vector<QString>(completions.begin(), completions.end())));
+}
+
+void TagsLineEdit::completion(CompletionDictionary dictionary) {
+    impl->setCompletions(std::make_shared<SharedCompletions>(std::move(dictionary)));
+}
+
+void TagsLineEdit::completion(std::shared_ptr<SharedCompletions const> completions) {
+    impl->setCompletions(std::move(completions));
+}
+
+void TagsLineEdit::completionUsage(std::shared_ptr<CompletionUsage> usage) {
+    impl->usage = usage ? std::move(usage) : std::make_shared<CompletionUsage>();
+}
+
+std::shared_ptr<CompletionUsage> TagsLineEdit::completionUsage() const {
+    return impl->usage;
+}
+
+void TagsLineEdit::completionProvider(CompletionProvider provider, std::chrono::milliseconds delay) {
+    impl->setCompletionProvider(std::move(provider), delay);
 }
 
 void TagsLineEdit::tags(std::vector<QString> const& tags) {
     impl->setTags(tags);
+    impl->measureTexts(font(), fontMetrics());
     impl->update1();
 }
 
 void TagsLineEdit::tags(QStringList const& tags) {
     impl->setTags(tags);
+    impl->measureTexts(font(), fontMetrics());
     impl->update1();
 }
 
+void TagsLineEdit::replaceTags(size_t pos, size_t count, std::vector<QString> const& tags) {
+    impl->replaceTags(pos, count, tags);
+    impl->measureTexts(font(), fontMetrics());
+    impl->update1(false);
+    impl->emitChanges(this);
+    emit tagsEdited();
+}
+
+void TagsLineEdit::replaceTags(size_t pos, size_t count, QStringList const& tags) {
+    impl->replaceTags(pos, count, tags);
+    impl->measureTexts(font(), fontMetrics());
+    impl->update1(false);
+    impl->emitChanges(this);
+    emit tagsEdited();
+}
+
+void TagsLineEdit::insertTags(size_t pos, std::vector<QString> const& tags) {
+    replaceTags(pos, 0, tags);
+}
+
+void TagsLineEdit::insertTags(size_t pos, QStringList const& tags) {
+    replaceTags(pos, 0, tags);
+}
+
+void TagsLineEdit::appendTags(std::vector<QString> const& tags) {
+    replaceTags(std::numeric_limits<size_t>::max(), 0, tags);
+}
+
+void TagsLineEdit::appendTags(QStringList const& tags) {
+    replaceTags(std::numeric_limits<size_t>::max(), 0, tags);
+}
+
+void TagsLineEdit::removeTags(size_t pos, size_t count) {
+    replaceTags(pos, count, std::vector<QString>{});
+}
+
 std::vector<QString> TagsLineEdit::tags() const {
     std::vector<QString> ret;
     impl->getTags(ret);
@@ -436,13 +476,29 @@ QStringList TagsLineEdit::tags2() const {
     return ret;
 }
 
+TagsView TagsLineEdit::tagsView() const {
+    return TagsView(*impl, this);
+}
+
+void TagsLineEdit::model(QAbstractItemModel* model, int column) {
+    impl->bindModel(this, model, column, [this] {
+        impl->update1(false);
+        impl->emitChanges(this);
+        emit tagsEdited();
+    });
+    impl->update1();
+}
+
+QAbstractItemModel* TagsLineEdit::model() const {
+    return impl->model;
+}
+
 void TagsLineEdit::mouseMoveEvent(QMouseEvent* event) {
     event->accept();
-    for (size_t i = 0; i < impl->tags.size(); ++i) {
-        if (impl->inCrossArea(i, event->pos(), impl->offset())) {
-            setCursor(Qt::ArrowCursor);
-            return;
-        }
+    if (auto const i = impl->tagAt(event->pos() + impl->offset());
+        i && impl->inCrossArea(*i, event->pos(), impl->offset())) {
+        setCursor(Qt::ArrowCursor);
+        return;
     }
     setCursor(Qt::IBeamCursor);
 }
@@ -460,7 +516,10 @@ void TagsLineEdit::config(Config config) {
         impl->removeDuplicates();
     }
     static_cast<StyleConfig&>(*impl) = config.style;
+    impl->internTags(config.behavior.intern_tags);
     static_cast<BehaviorConfig&>(*impl) = config.behavior;
+    impl->forgetChanges();
+    impl->invalidateMeasurements();
     impl->update1();
 }
 
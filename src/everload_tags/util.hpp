@@ -6,23 +6,37 @@
 #include <everload_tags/config.hpp>
 #include <ranges>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace everload_tags {
 
-inline void removeDuplicates(std::vector<Tag>& tags) {
+/// Removes the tags repeating the text of a previous one, preserving the order, in a single pass.
+/// \param index Follows the tag it points to, or the first tag with the same text if the former is removed
+inline void removeDuplicates(std::vector<Tag>& tags, size_t& index) {
     std::unordered_map<QString, size_t> unique;
-    for (auto const i : std::views::iota(size_t{0}, tags.size())) {
-        unique.emplace(tags[i].text, i);
-    }
+    unique.reserve(tags.size());
 
-    for (auto b = tags.rbegin(), it = b, e = tags.rend(); it != e;) {
-        if (auto const i = static_cast<size_t>(std::distance(it, e) - 1); unique.at(it->text) != i) {
-            tags.erase(it++.base() - 1);
-        } else {
-            ++it;
+    size_t w = 0;
+    for (auto const r : std::views::iota(size_t{0}, tags.size())) {
+        auto const [it, inserted] = unique.try_emplace(tags[r].text, w);
+        if (r == index) {
+            index = it->second;
+        }
+        if (inserted) {
+            if (w != r) {
+                tags[w] = std::move(tags[r]);
+            }
+            ++w;
         }
     }
+
+    tags.erase(tags.begin() + static_cast<std::ptrdiff_t>(w), tags.end());
+}
+
+inline void removeDuplicates(std::vector<Tag>& tags) {
+    auto index = tags.size();
+    removeDuplicates(tags, index);
 }
 
 } // namespace everload_tags
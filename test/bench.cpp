@@ -0,0 +1,186 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Nicolai Trandafil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ensure_app.hpp"
+
+#include <QApplication>
+#include <QImage>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QTemporaryDir>
+
+#include <catch2/catch_all.hpp>
+#include <everload_tags/completion.hpp>
+#include <everload_tags/completion_dictionary.hpp>
+#include <everload_tags/tags_edit.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace everload_tags;
+using everload_tags::test::ensureApp;
+
+namespace {
+
+vector<QString> makeTexts(int n) {
+    vector<QString> ret;
+    ret.reserve(static_cast<size_t>(n));
+    for (int i = 0; i < n; ++i) {
+        ret.push_back(QStringLiteral("tag%1").arg(i));
+    }
+    return ret;
+}
+
+void send(QObject* receiver, QEvent&& event) {
+    QApplication::sendEvent(receiver, &event);
+}
+
+} // namespace
+
+TEST_CASE("StyleConfig", "[benchmark]") {
+    ensureApp();
+    auto const n = GENERATE(10, 1'000, 100'000);
+    auto const suffix = " " + to_string(n);
+
+    vector<Tag> tags;
+    for (auto const& x : makeTexts(n)) {
+        tags.push_back(Tag{x, {}});
+    }
+
+    StyleConfig const style;
+    QFontMetrics const fm(QApplication::font());
+    QRect const fit(0, 0, 800, 600);
+
+    BENCHMARK("calcRects" + suffix) {
+        auto lt = fit.topLeft();
+        style.calcRects(lt, tags, fm, fit, true);
+        return lt;
+    };
+
+    auto lt = fit.topLeft();
+    style.calcRects(lt, tags, fm, fit, true);
+    QImage image(fit.size(), QImage::Format_ARGB32_Premultiplied);
+
+    BENCHMARK("drawTags" + suffix) {
+        QPainter p(&image);
+        style.drawTags(p, tags, fm, {}, true);
+    };
+}
+
+TEST_CASE("CompletionIndex", "[benchmark]") {
+    ensureApp();
+    auto const n = GENERATE(1'000, 1'000'000);
+    auto const suffix = " " + to_string(n);
+    auto const texts = makeTexts(n);
+
+    BENCHMARK("CompletionIndex" + suffix) {
+        return CompletionIndex(texts);
+    };
+
+    CompletionIndex const index(texts);
+
+    BENCHMARK("complete" + suffix) {
+        return index.complete(u"tag12", 100);
+    };
+
+    BENCHMARK("completeFuzzy" + suffix) {
+        return index.completeFuzzy(u"tga12", 100);
+    };
+
+    QTemporaryDir const dir;
+    auto const path = dir.filePath("tags.dic");
+    CompletionDictionary::write(path, texts);
+
+    BENCHMARK("CompletionDictionary::open" + suffix) {
+        return CompletionDictionary::open(path);
+    };
+
+    auto const dictionary = *CompletionDictionary::open(path);
+
+    BENCHMARK("CompletionDictionary::complete" + suffix) {
+        return dictionary.complete(u"tag12", 100);
+    };
+
+    BENCHMARK("CompletionDictionary::completeFuzzy" + suffix) {
+        return dictionary.completeFuzzy(u"tga12", 100);
+    };
+}
+
+TEST_CASE("TagsEdit", "[benchmark]") {
+    ensureApp();
+    auto const n = GENERATE(10, 1'000, 100'000);
+    auto const suffix = " " + to_string(n);
+    auto const texts = makeTexts(n);
+
+    TagsEdit edit;
+    edit.resize(800, 600);
+
+    BENCHMARK("set tags" + suffix) {
+        edit.tags(texts);
+    };
+
+    // The widths measured stay cached, so every run gets a new widget
+    for (auto const parallel : {false, true}) {
+        Config config;
+        config.behavior.parallel_measurement = parallel;
+        BENCHMARK_ADVANCED("set tags, unmeasured" + string(parallel ? ", parallel" : "") + suffix)(
+            Catch::Benchmark::Chronometer meter) {
+            vector<unique_ptr<TagsEdit>> edits;
+            for (int i = 0; i < meter.runs(); ++i) {
+                edits.push_back(make_unique<TagsEdit>(nullptr, config));
+                edits.back()->resize(800, 600);
+            }
+            meter.measure([&](int i) { edits[static_cast<size_t>(i)]->tags(texts); });
+        };
+    }
+
+    BENCHMARK("get tags" + suffix) {
+        return edit.tags();
+    };
+
+    BENCHMARK("heightForWidth" + suffix) {
+        static int width = 400;
+        width = width == 800 ? 400 : width + 1; // misses the memoized widths
+        return edit.heightForWidth(width);
+    };
+
+    BENCHMARK("heightForWidth memoized" + suffix) {
+        return edit.heightForWidth(800);
+    };
+
+    BENCHMARK("keyPressEvent" + suffix) {
+        // type a character and erase it
+        send(&edit, QKeyEvent(QEvent::KeyPress, Qt::Key_A, Qt::NoModifier, QStringLiteral("a")));
+        send(&edit, QKeyEvent(QEvent::KeyPress, Qt::Key_Backspace, Qt::NoModifier));
+    };
+
+    BENCHMARK("mousePressEvent" + suffix) {
+        // the text of the first tag, clear of its cross, so that every run edits the same tag
+        QPointF const pos(10, 10);
+        send(edit.viewport(),
+             QMouseEvent(QEvent::MouseButtonPress, pos, pos, Qt::LeftButton, Qt::LeftButton, Qt::NoModifier));
+    };
+}
@@ -0,0 +1,253 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Nicolai Trandafil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "ensure_app.hpp"
+
+#include <QApplication>
+#include <QStringListModel>
+
+#include <catch2/catch_all.hpp>
+#include <everload_tags/common.hpp>
+#include <vector>
+
+using namespace std;
+using namespace everload_tags;
+using everload_tags::test::ensureApp;
+
+namespace {
+
+/// Applies the change signals to a copy of the tags, the way a listener would
+struct Replica {
+    vector<QString> tags;
+    vector<pair<int, QString>> committed;
+
+    void tagsInserted(int pos, QStringList const& texts) {
+        REQUIRE(pos <= static_cast<int>(tags.size()));
+        tags.insert(tags.begin() + pos, texts.begin(), texts.end());
+    }
+
+    void tagsRemoved(int pos, QStringList const& texts) {
+        REQUIRE(pos + texts.size() <= static_cast<int>(tags.size()));
+        REQUIRE(vector<QString>(tags.begin() + pos, tags.begin() + pos + texts.size()) ==
+                vector<QString>(texts.begin(), texts.end()));
+        tags.erase(tags.begin() + pos, tags.begin() + pos + texts.size());
+    }
+
+    void tagModified(int pos, QString const& text) {
+        REQUIRE(pos < static_cast<int>(tags.size()));
+        tags[static_cast<size_t>(pos)] = text;
+    }
+
+    void tagCommitted(int pos, QString const& text) {
+        REQUIRE(pos < static_cast<int>(tags.size()));
+        REQUIRE(tags[static_cast<size_t>(pos)] == text);
+        committed.emplace_back(pos, text);
+    }
+};
+
+vector<QString> listed(Common const& common) {
+    vector<QString> ret;
+    common.getTags(ret);
+    return ret;
+}
+
+} // namespace
+
+TEST_CASE("Common reports the changes at the listed positions") {
+    ensureApp();
+    Common common{{}, {}, {}};
+    common.setTags(vector<QString>{"a", "b", "c"});
+    Replica replica{listed(common), {}};
+
+    auto const check = [&] {
+        common.emitChanges(&replica);
+        REQUIRE(replica.tags == listed(common));
+    };
+
+    common.editorText() = "x";
+    check();
+
+    SECTION("a new tag before the editor commits it where it is listed") {
+        common.editNewTag(1);
+        check();
+        REQUIRE(replica.committed == vector<pair<int, QString>>{{3, "x"}});
+    }
+
+    SECTION("a new tag after the editor") {
+        common.editNewTag(common.editing_index + 1);
+        check();
+        REQUIRE(replica.committed == vector<pair<int, QString>>{{3, "x"}});
+    }
+
+    SECTION("the editor typed into, then a new tag before it") {
+        common.editorText() = "xy";
+        common.editNewTag(0);
+        check();
+        REQUIRE(replica.committed == vector<pair<int, QString>>{{3, "xy"}});
+    }
+}
+
+TEST_CASE("Common hit-tests the laid out tags after the editor is marked dirty") {
+    ensureApp();
+    QObject owner;
+    QFontMetrics const fm(QApplication::font());
+    Common common{{}, {}, {}};
+    vector<QString> texts;
+    for (auto i = 0; i < 1000; ++i) {
+        texts.push_back(QString::number(i));
+    }
+    common.setTags(texts);
+    common.setCursorVisible(true, &owner);
+
+    auto const center = [&](size_t i) { return common.tags[i].rect.center(); };
+
+    SECTION("the editor in the middle") {
+        common.editTag(1);
+        common.relayout({}, fm, QRect(0, 0, 200, 100), true);
+        common.markDirty(common.editing_index); // as the cursor blinking does after an update
+        REQUIRE(common.laidOutEnd() == common.tags.size());
+        REQUIRE(common.tagAt(center(2)) == 2);
+        REQUIRE(common.tagsSpanning(QRect(0, 0, 200, 1 << 20)) == pair<size_t, size_t>{0, common.tags.size()});
+        REQUIRE(common.insertionIndex(common.tags[2].rect.topLeft()) == 2);
+    }
+
+    SECTION("the lazy layout stops above the editor") {
+        common.relayout({}, fm, QRect(0, 0, 200, 100), true, 100);
+        auto const laid = common.laidOutEnd();
+        REQUIRE(laid < common.editing_index);
+        REQUIRE_FALSE(common.editorPlaced());
+        common.markDirty(common.editing_index);
+        REQUIRE(common.laidOutEnd() == laid);
+        REQUIRE(common.tagAt(center(laid - 1)) == laid - 1);
+
+        common.relayout({}, fm, QRect(0, 0, 200, 100), true);
+        REQUIRE(common.editorPlaced());
+    }
+}
+
+TEST_CASE("Common follows a row inserted into the model, then set") {
+    ensureApp();
+    QObject context;
+    QStringListModel model(QStringList{"a", "", "b"});
+    Common common{{}, {}, {}};
+    Replica replica;
+    common.bindModel(&context, &model, 0, [&] { common.emitChanges(&replica); });
+    replica.tags = listed(common);
+    REQUIRE(replica.tags == vector<QString>{"a", "b"});
+
+    model.insertRows(2, 1);
+    REQUIRE(listed(common) == vector<QString>{"a", "b"});
+    model.setData(model.index(2), QString("x"));
+    REQUIRE(listed(common) == vector<QString>{"a", "x", "b"});
+    REQUIRE(replica.tags == listed(common)); // reported as an insertion, not resynced
+
+    // The widget's own changes go to the rows of the tags, past the empty one
+    common.replaceTags(2, 1, QStringList{});
+    common.emitChanges(&replica);
+    REQUIRE(model.stringList() == QStringList{"a", "", "x"});
+}
+
+TEST_CASE("Common removes the hidden editor at the front") {
+    ensureApp();
+    Common common{{}, {}, {}};
+
+    SECTION("the next tag becomes the editor") {
+        common.setTags(vector<QString>{"a", "b"});
+        common.editNewTag(0);
+        REQUIRE(common.editing_index == 0);
+        common.removeTag(0);
+        REQUIRE(common.editing_index == 0);
+        REQUIRE(common.editorText() == "a");
+        REQUIRE(listed(common) == vector<QString>{"a", "b"});
+        REQUIRE(common.text_counts.size() == 1);
+    }
+
+    SECTION("a single tag") {
+        common.setTags(vector<QString>{"a"});
+        common.editNewTag(0);
+        common.removeTag(0);
+        REQUIRE(common.tags.size() == 1);
+        REQUIRE(common.editorText() == "a");
+        REQUIRE(common.text_counts.empty());
+    }
+
+    SECTION("the editor alone gets an empty one") {
+        common.setTags(vector<QString>{});
+        common.removeTag(0);
+        REQUIRE(common.tags.size() == 1);
+        REQUIRE(common.editing_index == 0);
+        REQUIRE(common.editorText().isEmpty());
+        REQUIRE(listed(common).empty());
+    }
+}
+
+TEST_CASE("Common counts the use of the committed tags only") {
+    ensureApp();
+    Common common{{}, {}, {}};
+    common.setTags(vector<QString>{"a", "b"});
+
+    SECTION("space") {
+        common.editorText() = "x";
+        common.commitEditorText();
+        REQUIRE(common.usage->count("x") == 1);
+    }
+
+    SECTION("clicking another tag") {
+        common.editorText() = "x";
+        common.editTag(0);
+        REQUIRE(common.usage->count("x") == 1);
+    }
+
+    SECTION("a duplicate is dropped uncounted") {
+        common.editorText() = "a";
+        common.commitEditorText();
+        REQUIRE(common.usage->count("a") == 0);
+        REQUIRE(listed(common) == vector<QString>{"a", "b"});
+    }
+}
+
+TEST_CASE("Common references the pooled texts of its tags") {
+    ensureApp();
+    auto& pool = StringPool::global();
+    auto const before = pool.size();
+    {
+        Common common{{}, {}, {}};
+        common.internTags(true);
+        common.setTags(vector<QString>{"pooled a", "pooled b"});
+        REQUIRE(pool.size() == before + 2);
+
+        common.removeTag(1);
+        REQUIRE(pool.size() == before + 1);
+
+        common.replaceTags(1, 0, QStringList{"pooled c", "pooled a"}); // the duplicate is dropped
+        REQUIRE(pool.size() == before + 2);
+
+        common.internTags(false);
+        REQUIRE(pool.size() == before);
+        common.internTags(true);
+        REQUIRE(pool.size() == before + 2);
+    }
+    REQUIRE(pool.size() == before);
+}
@@ -0,0 +1,217 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2025 Nicolai Trandafil
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ensure_app.hpp"
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QSaveFile>
+#include <QTemporaryDir>
+#include <QTimer>
+
+#include <atomic>
+#include <catch2/catch_all.hpp>
+#include <everload_tags/completion.hpp>
+#include <everload_tags/completion_dictionary.hpp>
+#include <everload_tags/completion_usage.hpp>
+#include <everload_tags/shared_completions.hpp>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace everload_tags;
+
+TEST_CASE("CompletionIndex") {
+    CompletionIndex const index(vector<QString>{"beta", "Alpha", "alps", "alpha", "gamma", "beta"});
+    REQUIRE(index.size() == 5);
+
+    SECTION("prefix ignoring case") {
+        REQUIRE(index.complete(u"AL", 10) == QStringList{"Alpha", "alpha", "alps"});
+    }
+
+    SECTION("top k") {
+        REQUIRE(index.complete(u"al", 2) == QStringList{"Alpha", "alpha"});
+    }
+
+    SECTION("empty prefix") {
+        REQUIRE(index.complete(u"", 10) == QStringList{"Alpha", "alpha", "alps", "beta", "gamma"});
+    }
+
+    SECTION("no match") {
+        REQUIRE(index.complete(u"delta", 10).isEmpty());
+        REQUIRE(index.complete(u"alphabet", 10).isEmpty());
+    }
+}
+
+TEST_CASE("FuzzyPattern") {
+    using Score = FuzzyPattern::Score;
+    FuzzyPattern const pattern(u"Tag");
+
+    REQUIRE(pattern.score(u"tags") == Score{Score::prefix, 0, 4});
+    REQUIRE(pattern.score(u"stage") == Score{Score::substring, 0, 5});
+    REQUIRE(pattern.score(u"tirage") == Score{Score::subsequence, 0, 6});
+    REQUIRE(pattern.score(u"tog") == Score{Score::typo, 1, 3});
+    REQUIRE(!pattern.score(u"gat"));
+    REQUIRE(!FuzzyPattern(u"ta").score(u"to"));
+}
+
+TEST_CASE("CompletionIndex fuzzy") {
+    CompletionIndex const index(vector<QString>{"tog", "tirage", "stage", "tags", "Tag", "gat"});
+
+    REQUIRE(index.completeFuzzy(u"tag", 10) == QStringList{"Tag", "tags", "stage", "tirage", "tog"});
+    REQUIRE(index.completeFuzzy(u"tag", 2) == QStringList{"Tag", "tags"});
+    REQUIRE(index.completeFuzzy(u"tag", 0).isEmpty());
+}
+
+TEST_CASE("CompletionDictionary") {
+    QTemporaryDir const dir;
+    REQUIRE(dir.isValid());
+    auto const path = dir.filePath("tags.dic");
+    auto const prefix_index = GENERATE(true, false);
+
+    REQUIRE(CompletionDictionary::write(path, {"beta", "Alpha", "alps", "alpha", "gamma", "beta", "b"}, prefix_index));
+    auto const dictionary = CompletionDictionary::open(path);
+    REQUIRE(dictionary);
+    REQUIRE(dictionary->size() == 6);
+
+    SECTION("prefix ignoring case") {
+        REQUIRE(dictionary->complete(u"AL", 10) == QStringList{"Alpha", "alpha", "alps"});
+        REQUIRE(dictionary->complete(u"b", 10) == QStringList{"b", "beta"});
+        REQUIRE(dictionary->complete(u"bet", 10) == QStringList{"beta"});
+    }
+
+    SECTION("top k") {
+        REQUIRE(dictionary->complete(u"al", 2) == QStringList{"Alpha", "alpha"});
+    }
+
+    SECTION("empty prefix") {
+        REQUIRE(dictionary->complete(u"", 10) == QStringList{"Alpha", "alpha", "alps", "b", "beta", "gamma"});
+    }
+
+    SECTION("no match") {
+        REQUIRE(dictionary->complete(u"delta", 10).isEmpty());
+        REQUIRE(dictionary->complete(u"alphabet", 10).isEmpty());
+    }
+
+    SECTION("fuzzy") {
+        REQUIRE(dictionary->completeFuzzy(u"lph", 10) == QStringList{"Alpha", "alpha", "alps"});
+    }
+
+    SECTION("copies share the mapping") {
+        auto const copy = *dictionary;
+        REQUIRE(copy.bytes(0).data() == dictionary->bytes(0).data());
+    }
+}
+
+TEST_CASE("CompletionDictionary not a dictionary") {
+    QTemporaryDir const dir;
+    auto const path = dir.filePath("tags.dic");
+    QSaveFile file(path);
+    REQUIRE(file.open(QIODevice::WriteOnly));
+    file.write(QByteArray(64, 'x'));
+    REQUIRE(file.commit());
+
+    REQUIRE(!CompletionDictionary::open(path));
+    REQUIRE(!CompletionDictionary::open(dir.filePath("missing.dic")));
+}
+
+TEST_CASE("SharedCompletions") {
+    SharedCompletions completions(vector<QString>{"beta", "alpha"});
+    REQUIRE(completions.size() == 2);
+    REQUIRE(completions.complete(u"a", 10) == QStringList{"alpha"});
+
+    completions.set(vector<QString>{"alps", "gamma", "alpha"});
+    REQUIRE(completions.size() == 3);
+    REQUIRE(completions.complete(u"a", 10) == QStringList{"alpha", "alps"});
+    REQUIRE(completions.completeFuzzy(u"gma", 10) == QStringList{"gamma"});
+
+    REQUIRE(SharedCompletions().complete(u"a", 10).isEmpty());
+}
+
+TEST_CASE("CompletionUsage") {
+    CompletionUsage usage(3);
+    for (auto const* x : {"alpha", "alps", "alps", "beta", "alps", "beta", ""}) {
+        usage.record(x);
+    }
+    REQUIRE(usage.size() == 3);
+    REQUIRE(usage.count("alps") == 3);
+    REQUIRE(usage.count("gamma") == 0);
+
+    SECTION("top") {
+        REQUIRE(usage.top(u"", 10) == QStringList{"alps", "beta", "alpha"});
+        REQUIRE(usage.top(u"AL", 10) == QStringList{"alps", "alpha"});
+        REQUIRE(usage.top(u"al", 1) == QStringList{"alps"});
+    }
+
+    SECTION("rank") {
+        QStringList words{"gamma", "alpha", "beta", "delta", "alps"};
+        usage.rank(words);
+        REQUIRE(words == QStringList{"alps", "beta", "alpha", "gamma", "delta"});
+    }
+
+    SECTION("evicts the least used") {
+        usage.record("gamma");
+        REQUIRE(usage.size() == 3);
+        REQUIRE(usage.count("alpha") == 0);
+        REQUIRE(usage.count("gamma") == 2);
+    }
+
+    SECTION("save and restore") {
+        CompletionUsage restored(2);
+        REQUIRE(restored.restore(usage.save()));
+        REQUIRE(restored.size() == 2);
+        REQUIRE(restored.count("alps") == 3);
+        REQUIRE(restored.count("beta") == 2);
+
+        REQUIRE(!restored.restore(QByteArray("garbage")));
+        REQUIRE(!restored.restore(usage.save().left(20)));
+        REQUIRE(restored.count("alps") == 3);
+    }
+}
+
+TEST_CASE("AsyncCompletion") {
+    test::ensureApp();
+    QEventLoop loop;
+
+    std::atomic_int calls = 0;
+    vector<pair<QString, QStringList>> delivered;
+    AsyncCompletion completion(
+        [&](QString const& prefix, std::stop_token) {
+            ++calls;
+            return QStringList{prefix + "1"};
+        },
+        std::chrono::milliseconds(10), qApp,
+        [&](QString const& prefix, QStringList const& completions) {
+            delivered.emplace_back(prefix, completions);
+            loop.quit();
+        });
+
+    completion.request("a");
+    completion.request("ab");
+    QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    REQUIRE(calls == 1);
+    REQUIRE(delivered == vector<pair<QString, QStringList>>{{"ab", {"ab1"}}});
+}
@@ -23,6 +23,7 @@
  */
 
 #include <catch2/catch_all.hpp>
+#include <everload_tags/string_pool.hpp>
 #include <everload_tags/util.hpp>
 
 using namespace std;
@@ -39,3 +40,84 @@ TEST_CASE("removeDuplicates does nothing") {
     removeDuplicates(tags);
     REQUIRE(tags == vector{Tag{"1", {}}, Tag{"2", {}}});
 }
+
+TEST_CASE("removeDuplicates keeps the first occurrences in order") {
+    vector tags{Tag{"3", {}}, Tag{"1", {}}, Tag{"3", {}}, Tag{"2", {}}, Tag{"1", {}}};
+    removeDuplicates(tags);
+    REQUIRE(tags == vector{Tag{"3", {}}, Tag{"1", {}}, Tag{"2", {}}});
+}
+
+TEST_CASE("removeDuplicates tracks the index") {
+    vector tags{Tag{"1", {}}, Tag{"2", {}}, Tag{"1", {}}, Tag{"3", {}}};
+
+    SECTION("kept tag") {
+        size_t index = 3;
+        removeDuplicates(tags, index);
+        REQUIRE(tags == vector{Tag{"1", {}}, Tag{"2", {}}, Tag{"3", {}}});
+        REQUIRE(index == 2);
+    }
+
+    SECTION("removed tag") {
+        size_t index = 2;
+        removeDuplicates(tags, index);
+        REQUIRE(tags == vector{Tag{"1", {}}, Tag{"2", {}}, Tag{"3", {}}});
+        REQUIRE(index == 0);
+    }
+}
+
+TEST_CASE("removeDuplicates benchmark", "[!benchmark]") {
+    constexpr size_t n = 100'000;
+
+    auto const make_tags = [](size_t distinct) {
+        vector<Tag> tags;
+        tags.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            tags.push_back(Tag{QString::number(static_cast<long long>(i % distinct)), {}});
+        }
+        return tags;
+    };
+
+    auto const heavy = make_tags(100);
+    BENCHMARK_ADVANCED("100k tags, 100 distinct")(Catch::Benchmark::Chronometer meter) {
+        vector runs(static_cast<size_t>(meter.runs()), heavy);
+        meter.measure([&](int i) {
+            removeDuplicates(runs[static_cast<size_t>(i)]);
+            return runs[static_cast<size_t>(i)].size();
+        });
+    };
+
+    auto const distinct = make_tags(n);
+    BENCHMARK_ADVANCED("100k tags, all distinct")(Catch::Benchmark::Chronometer meter) {
+        vector runs(static_cast<size_t>(meter.runs()), distinct);
+        meter.measure([&](int i) {
+            removeDuplicates(runs[static_cast<size_t>(i)]);
+            return runs[static_cast<size_t>(i)].size();
+        });
+    };
+}
+
+TEST_CASE("StringPool") {
+    StringPool pool;
+    QString const a = QString::fromUtf8("tag");
+    auto const x = pool.intern(a);
+    auto const y = pool.intern(QString::fromUtf8("tag"));
+    REQUIRE(x == a);
+    REQUIRE(y.constData() == x.constData());
+    REQUIRE(pool.size() == 1);
+
+    SECTION("empty texts are not pooled") {
+        REQUIRE(pool.intern(QString()).isEmpty());
+        REQUIRE(pool.size() == 1);
+    }
+
+    SECTION("a text leaves with its last reference") {
+        pool.release(x);
+        REQUIRE(pool.size() == 1);
+        REQUIRE(pool.intern(QString::fromUtf8("tag")).constData() == x.constData());
+        pool.release(x);
+        pool.release(x);
+        REQUIRE(pool.size() == 0);
+        pool.release(x); // not pooled, ignored
+        REQUIRE(pool.size() == 0);
+    }
+}